@@ -0,0 +1,125 @@
+// Plays an arpeggiated C major chord through the timerfd speaker engine at
+// several arpeggio rates, recording to a temporary file instead of the pc
+// speaker, and measures how evenly the tone switches land: the error of each
+// step's length against the nominal step, and each switch's lateness. The
+// CPU time the process used shows the engine sleeps between switches
+// instead of spinning.
+//
+// Usage: bench_arpeggio [seconds_per_rate]
+
+#include "benchreport.h"
+#include "scheduler.h"
+#include "speaker.h"
+#include "speakerengine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+int64_t cpuNs() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return (static_cast<int64_t>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) *
+              1000000 +
+          usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) *
+         1000;
+}
+
+std::vector<SongEvent> chord(uint32_t durationUs) {
+  std::vector<SongEvent> events;
+  for (const float frequency : {261.63f, 329.63f, 392.00f}) {
+    SongEvent event{};
+    event.kind = SongEvent::Kind::Note;
+    event.frequency = frequency;
+    event.durationUs = durationUs;
+    events.push_back(event); // all start together: delayUs stays 0
+  }
+  return events;
+}
+
+std::vector<int64_t> recordedNs(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  std::vector<int64_t> times;
+  Speaker::EventVal event;
+  while (in.read(reinterpret_cast<char *>(&event), sizeof event))
+    times.push_back(static_cast<int64_t>(event.t_val.tv_sec) * 1000000000LL +
+                    static_cast<int64_t>(event.t_val.tv_usec) * 1000);
+  return times;
+}
+
+double percentile(std::vector<double> values, double fraction) {
+  std::sort(values.begin(), values.end());
+  return values[static_cast<std::size_t>((values.size() - 1) * fraction)];
+}
+} // namespace
+
+int main(int argc, char **argv) try {
+  const double seconds = argc >= 2 ? std::strtod(argv[1], nullptr) : 2.0;
+  if (seconds <= 0.0)
+    throw std::runtime_error("seconds must be positive");
+
+  char path[] = "/tmp/bench_arpeggioXXXXXX";
+  const int fd = mkstemp(path);
+  if (fd == -1)
+    throw std::runtime_error("cannot create a temporary file");
+  close(fd);
+
+  std::cout << "arpeggio: C major chord for " << seconds
+            << " s per rate, recorded to " << path << "\n";
+  BenchReport json("arpeggio");
+  for (const double rateHz : {50.0, 60.0, 120.0}) {
+    VectorEventSource song(chord(static_cast<uint32_t>(seconds * 1e6)));
+    const std::vector<ToneChange> tones = arpeggioTimeline(song, rateHz);
+
+    Speaker speaker(path);
+    SpeakerEngine engine(speaker);
+    const int64_t originNs = Scheduler::nowNs() + 10000000; // 10 ms to get going
+    const int64_t cpuBeforeNs = cpuNs();
+    engine.start(tones, originNs);
+    engine.join();
+    const double cpuShare =
+        static_cast<double>(cpuNs() - cpuBeforeNs) / (Scheduler::nowNs() - originNs);
+
+    const std::vector<int64_t> times = recordedNs(path);
+    if (times.size() < tones.size())
+      throw std::runtime_error("recording is incomplete");
+    std::vector<double> stepErrorUs;
+    std::vector<double> lateUs;
+    for (std::size_t i = 0; i < tones.size(); ++i) {
+      lateUs.push_back(
+          (times[i] - originNs - static_cast<int64_t>(tones[i].atUs) * 1000) /
+          1e3);
+      if (i > 0)
+        stepErrorUs.push_back(std::abs(
+            (times[i] - times[i - 1]) / 1e3 -
+            static_cast<double>(tones[i].atUs - tones[i - 1].atUs)));
+    }
+    std::cout << "  " << rateHz << " Hz: " << tones.size()
+              << " switches, step error p50 " << percentile(stepErrorUs, 0.5)
+              << " us, p99 " << percentile(stepErrorUs, 0.99) << " us, max "
+              << percentile(stepErrorUs, 1.0) << " us; lateness p99 "
+              << percentile(lateUs, 0.99) << " us; CPU "
+              << cpuShare * 100.0 << "% of one core\n";
+    const std::string name = std::to_string(static_cast<int>(rateHz)) + " Hz";
+    json.add(name + " step error p50", percentile(stepErrorUs, 0.5), "us");
+    json.add(name + " step error p99", percentile(stepErrorUs, 0.99), "us");
+    json.add(name + " step error max", percentile(stepErrorUs, 1.0), "us");
+    json.add(name + " lateness p99", percentile(lateUs, 0.99), "us");
+    json.add(name + " cpu", cpuShare * 100.0, "%");
+  }
+  unlink(path);
+  json.write();
+  return EXIT_SUCCESS;
+} catch (const std::exception &e) {
+  std::cerr << "Error: " << e.what() << '\n';
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Machine-readable results of one benchmark, next to its text output. When
+// the BENCH_JSON_DIR environment variable is set (as 'make bench' does),
+// write() stores them as <dir>/<benchmark>.json:
+//
+//   {"benchmark": "drawer", "results": [
+//     {"name": "terminal 1 note/frame", "value": 812.5, "unit": "ns/frame"}]}
+//
+// Names are stable between versions, so two runs can be compared entry by
+// entry to spot regressions.
+class BenchReport {
+public:
+  explicit BenchReport(std::string benchmark)
+      : benchmark_(std::move(benchmark)) {}
+
+  void add(std::string name, double value, std::string unit) {
+    results_.push_back({std::move(name), value, std::move(unit)});
+  }
+
+  // Does nothing unless BENCH_JSON_DIR is set.
+  void write() const {
+    const char *dir = std::getenv("BENCH_JSON_DIR");
+    if (dir == nullptr || *dir == '\0')
+      return;
+    const std::string path = std::string(dir) + "/" + benchmark_ + ".json";
+    std::ofstream out(path);
+    if (!out.is_open())
+      throw std::runtime_error("Failed to create " + path);
+    out << "{\"benchmark\": " << quoted(benchmark_) << ", \"results\": [";
+    for (std::size_t i = 0; i < results_.size(); ++i) {
+      const Result &result = results_[i];
+      out << (i == 0 ? "\n" : ",\n") << "  {\"name\": " << quoted(result.name)
+          << ", \"value\": " << number(result.value)
+          << ", \"unit\": " << quoted(result.unit) << "}";
+    }
+    out << "\n]}\n";
+  }
+
+private:
+  struct Result {
+    std::string name;
+    double value;
+    std::string unit;
+  };
+
+  static std::string quoted(const std::string &text) {
+    std::string out = "\"";
+    for (const char c : text) {
+      if (c == '"' || c == '\\')
+        out += '\\';
+      out += c;
+    }
+    return out + "\"";
+  }
+
+  // JSON has no NaN or infinity.
+  static std::string number(double value) {
+    if (!std::isfinite(value))
+      return "null";
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.6g", value);
+    return text;
+  }
+
+  std::string benchmark_;
+  std::vector<Result> results_;
+};
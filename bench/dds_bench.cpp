@@ -0,0 +1,114 @@
+// Compares the cost per sample of the float oscillator paths with the
+// fixed-point DDS oscillator, rendering in callback-sized buffers. Cycles are
+// read from the time-stamp counter where there is one (x86), so they count
+// reference cycles at the TSC rate rather than core clock cycles.
+//
+// Usage: bench_dds [seconds_of_audio] [frames_per_buffer]
+
+#include "dds.h"
+#include "benchreport.h"
+#include "oscillator.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace {
+using Clock = std::chrono::steady_clock;
+constexpr double SAMPLE_RATE = 48000.0;
+constexpr double FREQUENCY = 440.0;
+
+uint64_t cycleCounter() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+struct Cost {
+  double nsPerSample;
+  double cyclesPerSample; // 0 where there is no cycle counter
+};
+
+template <typename Fn>
+Cost measure(std::size_t samples, std::size_t frames, Fn &&renderBuffer) {
+  const auto start = Clock::now();
+  const uint64_t startCycles = cycleCounter();
+  for (std::size_t done = 0; done < samples; done += frames)
+    renderBuffer();
+  const uint64_t cycles = cycleCounter() - startCycles;
+  const double ns =
+      std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  return {ns / samples, static_cast<double>(cycles) / samples};
+}
+
+void print(BenchReport &json, const std::string &waveform,
+           const std::string &name, const Cost &cost) {
+  json.add(waveform + " " + name, cost.nsPerSample, "ns/sample");
+  if (cost.cyclesPerSample > 0.0)
+    json.add(waveform + " " + name, cost.cyclesPerSample, "cycles/sample");
+  std::cout << "  " << name << ": " << cost.nsPerSample << " ns/sample";
+  if (cost.cyclesPerSample > 0.0)
+    std::cout << ", " << cost.cyclesPerSample << " cycles/sample";
+  std::cout << "\n";
+}
+} // namespace
+
+int main(int argc, char **argv) try {
+  const double seconds = argc >= 2 ? std::strtod(argv[1], nullptr) : 60.0;
+  const std::size_t frames =
+      argc >= 3 ? std::strtoul(argv[2], nullptr, 10) : 256;
+  if (frames == 0)
+    throw std::runtime_error("frames_per_buffer must be positive");
+  const std::size_t samples =
+      static_cast<std::size_t>(seconds * SAMPLE_RATE) / frames * frames;
+
+  std::cout << "dds: " << samples << " samples in " << frames
+            << "-frame buffers\n";
+
+  static constexpr osc::Waveform WAVEFORMS[] = {
+      osc::Waveform::Sine, osc::Waveform::Square, osc::Waveform::Sawtooth,
+      osc::Waveform::Triangle};
+  std::vector<float> floats(frames);
+  std::vector<int16_t> ints(frames);
+  BenchReport json("dds");
+  long long sink = 0;
+  for (osc::Waveform waveform : WAVEFORMS) {
+    const std::string wave = osc::waveformName(waveform);
+    std::cout << wave << "\n";
+    for (osc::Isa isa : {osc::Isa::Scalar, osc::bestIsa()}) {
+      const osc::BlockKernel kernel = osc::kernelFor(waveform, isa);
+      double phase = 0.0;
+      const Cost cost = measure(samples, frames, [&] {
+        kernel(floats.data(), frames, phase, FREQUENCY / SAMPLE_RATE);
+        sink += static_cast<long long>(floats[frames / 2] * 1000.0f);
+      });
+      print(json, wave, std::string("float ") + osc::isaName(isa), cost);
+      if (isa == osc::bestIsa())
+        break;
+    }
+    const int16_t *lut = osc::dds::lutFor(waveform);
+    const uint32_t increment =
+        osc::dds::phaseIncrement(FREQUENCY, SAMPLE_RATE);
+    uint32_t phase = 0;
+    const Cost cost = measure(samples, frames, [&] {
+      osc::dds::render(lut, ints.data(), frames, phase, increment);
+      sink += ints[frames / 2];
+    });
+    print(json, wave, "dds int16", cost);
+  }
+  json.write();
+  // Printed so the renders cannot be optimised away.
+  std::cout << "checksum " << sink << "\n";
+  return EXIT_SUCCESS;
+} catch (const std::exception &e) {
+  std::cerr << "Error: " << e.what() << '\n';
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,78 @@
+// Measures the cost of a frame in a headless NcursesDrawer: notes are drawn
+// into the in-memory cell buffer and present() works out which cells
+// changed, exactly as on a terminal but without the terminal. Cells per
+// frame are what would be sent to the screen, against the whole screen that
+// a full repaint sends.
+//
+// Usage: bench_drawer [frames]
+
+#include "NcursesDrawer.h"
+#include "benchreport.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct Scale {
+  const char *name;
+  int lines;
+  int cols;
+};
+
+// Draws `notesPerFrame` notes per frame, walking up and down an octave so
+// stems point both ways and the staff wraps to a new page regularly.
+void run(BenchReport &json, const Scale &scale, int notesPerFrame,
+         uint64_t frames) {
+  static const char *const NAMES[] = {"C", "D", "E", "F", "G", "A", "B", "C#"};
+  NcursesDrawer drawer(scale.lines, scale.cols);
+  drawer.drawStaff(60);
+  drawer.present();
+  const NcursesDrawer::FrameStats before = drawer.frameStats();
+  int counter = 0;
+  const auto start = Clock::now();
+  for (uint64_t frame = 0; frame < frames; ++frame) {
+    for (int i = 0; i < notesPerFrame; ++i, ++counter) {
+      const int step = counter % 16 < 8 ? counter % 8 : 7 - counter % 8;
+      drawer.drawNote(NAMES[step], 4, "e", 8, 1, 60, 60 + step * 2, counter);
+    }
+    drawer.drawStatus("frame " + std::to_string(frame));
+    drawer.present();
+  }
+  const double ns =
+      std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  const NcursesDrawer::FrameStats after = drawer.frameStats();
+  const double cells =
+      static_cast<double>(after.cellsWritten - before.cellsWritten) / frames;
+  std::cout << "  " << scale.name << " (" << scale.lines << "x" << scale.cols
+            << "), " << notesPerFrame << " note(s)/frame: " << ns / frames
+            << " ns/frame, " << cells
+            << " cells/frame (full repaint: " << scale.lines * scale.cols
+            << ")\n";
+  const std::string name = std::string(scale.name) + " " +
+                           std::to_string(notesPerFrame) + " note/frame";
+  json.add(name, ns / frames, "ns/frame");
+  json.add(name + " cells", cells, "cells/frame");
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  const uint64_t frames =
+      argc >= 2 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+  if (frames == 0) {
+    std::cerr << "frames must be positive\n";
+    return EXIT_FAILURE;
+  }
+  std::cout << "drawer: " << frames << " headless frames\n";
+  BenchReport json("drawer");
+  for (const Scale &scale :
+       {Scale{"terminal", 24, 80}, Scale{"large terminal", 60, 240}})
+    for (const int notesPerFrame : {1, 8})
+      run(json, scale, notesPerFrame, frames);
+  json.write();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+// Times the MIDI importer on a synthetic orchestral-sized Standard MIDI File:
+// a tempo track that changes tempo every bar plus `tracks` instrument tracks
+// of interleaved notes, all merged into one event sequence. Checks that the
+// events come out in onset order and that none are lost.
+//
+// Usage: bench_midi [tracks] [notes_per_track]
+
+#include "benchreport.h"
+#include "eventsource.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+constexpr unsigned DIVISION = 480; // ticks per quarter note
+
+void putBig(std::string &out, uint32_t value, int bytes) {
+  for (int i = bytes - 1; i >= 0; --i)
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+}
+
+void putVlq(std::string &out, uint32_t value) {
+  char bytes[4];
+  int count = 0;
+  do {
+    bytes[count++] = static_cast<char>(value & 0x7F);
+    value >>= 7;
+  } while (value);
+  while (count > 1)
+    out.push_back(static_cast<char>(bytes[--count] | 0x80));
+  out.push_back(bytes[0]);
+}
+
+void putTrack(std::string &out, const std::string &events) {
+  out += "MTrk";
+  putBig(out, static_cast<uint32_t>(events.size()), 4);
+  out += events;
+}
+
+std::string buildFile(unsigned tracks, unsigned notes) {
+  std::string file = "MThd";
+  putBig(file, 6, 4);
+  putBig(file, 1, 2);
+  putBig(file, tracks + 1, 2);
+  putBig(file, DIVISION, 2);
+
+  // Tempo track: a new tempo every bar, swinging between 90 and 150 bpm.
+  std::string tempo;
+  const unsigned bars = notes / 8 + 1;
+  for (unsigned bar = 0; bar < bars; ++bar) {
+    putVlq(tempo, bar == 0 ? 0 : 4 * DIVISION);
+    tempo += "\xFF\x51\x03";
+    putBig(tempo, 60000000 / (90 + bar % 61), 3);
+  }
+  tempo += std::string("\x00\xFF\x2F\x00", 4);
+  putTrack(file, tempo);
+
+  // Each track plays eighth notes offset by its index, with running status
+  // and note-on velocity 0 as note-off, as most sequencers write them.
+  for (unsigned track = 0; track < tracks; ++track) {
+    std::string events;
+    const unsigned channel = track % 16 == 9 ? 10 : track % 16;
+    putVlq(events, track);
+    events.push_back(static_cast<char>(0x90 | channel));
+    for (unsigned note = 0; note < notes; ++note) {
+      const char key = static_cast<char>(36 + (track * 5 + note * 7) % 60);
+      if (note > 0)
+        putVlq(events, DIVISION / 8);
+      events.push_back(key);
+      events.push_back(100);
+      putVlq(events, DIVISION * 3 / 8);
+      events.push_back(key);
+      events.push_back(0);
+    }
+    events += std::string("\x00\xFF\x2F\x00", 4);
+    putTrack(file, events);
+  }
+  return file;
+}
+} // namespace
+
+int main(int argc, char **argv) try {
+  const unsigned tracks = argc >= 2 ? std::strtoul(argv[1], nullptr, 10) : 32;
+  const unsigned notes =
+      argc >= 3 ? std::strtoul(argv[2], nullptr, 10) : 20000;
+  if (tracks == 0 || tracks > 1000 || notes == 0)
+    throw std::runtime_error("need 1 to 1000 tracks and at least one note");
+
+  char path[] = "/tmp/bench_midiXXXXXX";
+  const int fd = mkstemp(path);
+  if (fd == -1)
+    throw std::runtime_error("cannot create a temporary file");
+  close(fd);
+  const std::string file = buildFile(tracks, notes);
+  std::ofstream(path, std::ios::binary) << file;
+  std::cout << "midi: " << tracks << " tracks x " << notes << " notes, "
+            << file.size() / 1e6 << " MB\n";
+
+  BenchReport json("midi");
+  for (int run = 0; run < 3; ++run) {
+    const auto start = Clock::now();
+    const auto song = openSong(path, 48000.0);
+    SongEvent event;
+    uint64_t events = 0;
+    uint64_t onsetUs = 0;
+    while (song->next(event)) {
+      // An onset earlier than the previous one would wrap delayUs.
+      if (event.delayUs > UINT32_MAX / 2)
+        throw std::runtime_error("events out of onset order");
+      onsetUs += event.delayUs;
+      ++events;
+    }
+    const double ms =
+        std::chrono::duration<double, std::milli>(Clock::now() - start)
+            .count();
+    if (events != uint64_t{tracks} * notes)
+      throw std::runtime_error("expected " +
+                               std::to_string(uint64_t{tracks} * notes) +
+                               " events, got " + std::to_string(events));
+    std::cout << "  run " << run + 1 << ": " << events << " events, "
+              << onsetUs / 1e6 << " s of music, " << ms << " ms ("
+              << events / ms / 1000 << " M events/s)\n";
+    json.add("run " + std::to_string(run + 1), events / ms / 1000,
+             "M events/s");
+  }
+  unlink(path);
+  json.write();
+  return EXIT_SUCCESS;
+} catch (const std::exception &e) {
+  std::cerr << "Error: " << e.what() << '\n';
+  return EXIT_FAILURE;
+}
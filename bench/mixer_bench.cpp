@@ -0,0 +1,91 @@
+// Measures what one audio callback costs as the number of sounding voices
+// grows, and how many voices fit in the callback's real-time budget (the
+// time the buffer takes to play) on one core, for each oscillator engine.
+//
+// Usage: bench_mixer [frames_per_buffer] [callbacks_per_run]
+
+#include "benchreport.h"
+#include "dds.h"
+#include "mixer.h"
+#include "oscillator.h"
+#include "wavetable.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+constexpr double SAMPLE_RATE = 48000.0;
+
+// Average seconds per callback with `voices` notes held for the whole run.
+template <typename Sample>
+double callbackSeconds(Mixer &mixer, std::size_t voices, std::size_t frames,
+                       std::size_t callbacks) {
+  mixer.releaseAll();
+  for (std::size_t v = 0; v < voices; ++v) {
+    const double frequency = 110.0 * (1.0 + 0.37 * v);
+    mixer.noteOn(0, Mixer::SUSTAIN, frequency / SAMPLE_RATE,
+                 osc::dds::phaseIncrement(frequency, SAMPLE_RATE));
+  }
+  std::vector<Sample> out(frames);
+  uint64_t frame = 0;
+  const auto start = Clock::now();
+  for (std::size_t c = 0; c < callbacks; ++c) {
+    mixer.render(out.data(), frames, frame);
+    frame += frames;
+  }
+  return std::chrono::duration<double>(Clock::now() - start).count() /
+         callbacks;
+}
+
+template <typename Sample>
+void report(BenchReport &json, const char *name, Mixer mixer,
+            std::size_t frames, std::size_t callbacks) {
+  const double budget = frames / SAMPLE_RATE;
+  std::cout << name << "\n";
+  double perVoice = 0.0;
+  for (std::size_t voices = 1; voices <= Mixer::MAX_VOICES; voices *= 2) {
+    const double seconds =
+        callbackSeconds<Sample>(mixer, voices, frames, callbacks);
+    perVoice = seconds / voices;
+    std::cout << "  " << voices << " voices: " << seconds * 1e6
+              << " us/callback, " << 100.0 * seconds / budget
+              << "% of budget\n";
+    json.add(std::string(name) + " " + std::to_string(voices) + " voices",
+             seconds * 1e6, "us/callback");
+  }
+  std::cout << "  ~" << static_cast<std::size_t>(budget / perVoice)
+            << " voices would fill the " << budget * 1e3
+            << " ms budget (pool holds " << Mixer::MAX_VOICES << ")\n";
+}
+} // namespace
+
+int main(int argc, char **argv) try {
+  const std::size_t frames =
+      argc >= 2 ? std::strtoul(argv[1], nullptr, 10) : 256;
+  const std::size_t callbacks =
+      argc >= 3 ? std::strtoul(argv[2], nullptr, 10) : 2000;
+  if (frames == 0 || callbacks == 0)
+    throw std::runtime_error("arguments must be positive");
+
+  std::cout << "mixer: " << frames << "-frame callbacks, " << callbacks
+            << " per run\n";
+  const osc::Waveform waveform = osc::Waveform::Sawtooth;
+  BenchReport json("mixer");
+  report<float>(json, "formula (best isa)", Mixer(osc::kernelFor(waveform)),
+                frames, callbacks);
+  report<float>(json, "wavetable", Mixer(osc::wavetableKernel(waveform)),
+                frames, callbacks);
+  report<int16_t>(json, "dds int16",
+                  Mixer(nullptr, osc::dds::lutFor(waveform)), frames,
+                  callbacks);
+  json.write();
+  return EXIT_SUCCESS;
+} catch (const std::exception &e) {
+  std::cerr << "Error: " << e.what() << '\n';
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,73 @@
+// Measures the cost of NotePlayer's lookups: a note name and octave to a
+// frequency, a MIDI note number to a frequency, and a note value and tempo to
+// a duration, cycling through every note name and value the score grammar
+// accepts.
+//
+// Usage: bench_noteplayer [lookups]
+
+#include "benchreport.h"
+#include "noteplayer.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+const std::string NOTES[] = {"C",  "C#", "Db", "D",  "D#", "Eb", "E",
+                             "F",  "F#", "Gb", "G",  "G#", "Ab", "A",
+                             "A#", "Bb", "B"};
+const std::string VALUES[] = {"w", "h", "q", "e", "s", "t", "sf"};
+constexpr std::size_t NOTE_COUNT = sizeof(NOTES) / sizeof(NOTES[0]);
+constexpr std::size_t VALUE_COUNT = sizeof(VALUES) / sizeof(VALUES[0]);
+
+template <typename Fn>
+double nsPerLookup(uint64_t lookups, double &sink, Fn &&fn) {
+  const auto start = Clock::now();
+  for (uint64_t i = 0; i < lookups; ++i)
+    sink += fn(i);
+  const double ns =
+      std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  return ns / lookups;
+}
+
+void report(BenchReport &json, const char *name, double ns) {
+  std::cout << "  " << name << ": " << ns << " ns/lookup\n";
+  json.add(name, ns, "ns/lookup");
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  const uint64_t lookups =
+      argc >= 2 ? std::strtoull(argv[1], nullptr, 10) : 50000000;
+  if (lookups == 0) {
+    std::cerr << "lookups must be positive\n";
+    return EXIT_FAILURE;
+  }
+  std::cout << "noteplayer: " << lookups << " lookups each\n";
+
+  const NotePlayer player;
+  BenchReport json("noteplayer");
+  double sink = 0.0;
+  report(json, "frequency by name",
+         nsPerLookup(lookups, sink, [&](uint64_t i) {
+           return player.getFrequency(NOTES[i % NOTE_COUNT],
+                                      static_cast<int>(i % 8));
+         }));
+  report(json, "frequency by midi",
+         nsPerLookup(lookups, sink, [&](uint64_t i) {
+           return player.getFrequency(static_cast<int>(i % 128));
+         }));
+  report(json, "duration",
+         nsPerLookup(lookups, sink, [&](uint64_t i) {
+           return static_cast<double>(player.getDurationUs(
+               VALUES[i % VALUE_COUNT], 60 + static_cast<int>(i % 180)));
+         }));
+  json.write();
+  // Printed so the lookups cannot be optimised away.
+  std::cout << "checksum " << sink << "\n";
+  return EXIT_SUCCESS;
+}
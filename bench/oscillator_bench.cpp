@@ -0,0 +1,175 @@
+// Compares the per-sample std::function oscillator the soundcard callback
+// used to run against the block kernels in oscillator.h and the band-limited
+// wavetables in wavetable.h, rendering in callback-sized buffers. Also
+// reports each formula kernel's worst-case deviation from the
+// double-precision reference waveform.
+//
+// Usage: bench_oscillator [seconds_of_audio] [frames_per_buffer]
+
+#include "benchreport.h"
+#include "oscillator.h"
+#include "wavetable.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+constexpr double SAMPLE_RATE = 48000.0;
+constexpr double FREQUENCY = 440.0;
+constexpr double TWO_PI = 6.28318530717958647692;
+
+// The waveforms exactly as SoundPlayer evaluated them before the kernels.
+double sineWave(double phase) { return std::sin(TWO_PI * phase); }
+double sawtoothWave(double phase) {
+  return 2.0 * (phase - static_cast<int>(phase + 0.5));
+}
+double squareWave(double phase) {
+  return 4.0 * static_cast<int>(phase) - 2.0 * static_cast<int>(2 * phase) +
+         1.0;
+}
+double triangleWave(double phase) {
+  return 4.0 * std::abs(phase - std::floor(phase + 0.75) + 0.25) - 1.0;
+}
+
+std::function<double(double)> legacyFunc(osc::Waveform waveform) {
+  switch (waveform) {
+  case osc::Waveform::Square:
+    return squareWave;
+  case osc::Waveform::Sawtooth:
+    return sawtoothWave;
+  case osc::Waveform::Triangle:
+    return triangleWave;
+  case osc::Waveform::Sine:
+  default:
+    return sineWave;
+  }
+}
+
+struct Result {
+  double nsPerSample;
+  double checksum;
+};
+
+Result runLegacy(const std::function<double(double)> &waveFunc,
+                 std::size_t samples, std::size_t frames) {
+  std::vector<float> buffer(frames);
+  double phase = 0.0;
+  const double increment = FREQUENCY / SAMPLE_RATE;
+  double checksum = 0.0;
+  const auto start = Clock::now();
+  for (std::size_t done = 0; done < samples; done += frames) {
+    for (std::size_t i = 0; i < frames; ++i) {
+      buffer[i] = waveFunc(phase);
+      phase += increment;
+      if (phase >= 1.0)
+        phase -= 1.0;
+    }
+    checksum += buffer[done % frames];
+  }
+  const double ns =
+      std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  return {ns / samples, checksum};
+}
+
+Result runKernel(osc::BlockKernel kernel, std::size_t samples,
+                 std::size_t frames) {
+  std::vector<float> buffer(frames);
+  double phase = 0.0;
+  const double increment = FREQUENCY / SAMPLE_RATE;
+  double checksum = 0.0;
+  const auto start = Clock::now();
+  for (std::size_t done = 0; done < samples; done += frames) {
+    kernel(buffer.data(), frames, phase, increment);
+    checksum += buffer[done % frames];
+  }
+  const double ns =
+      std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  return {ns / samples, checksum};
+}
+
+// Largest difference from the reference over one second of audio rendered in
+// `frames`-sized buffers, skipping the samples next to a discontinuity where
+// a rounding difference in phase legitimately flips the output.
+double maxError(osc::BlockKernel kernel, osc::Waveform waveform,
+                std::size_t frames) {
+  const std::size_t total =
+      static_cast<std::size_t>(SAMPLE_RATE) / frames * frames;
+  std::vector<float> buffer(total);
+  double phase = 0.0;
+  const double increment = FREQUENCY / SAMPLE_RATE;
+  for (std::size_t done = 0; done < total; done += frames)
+    kernel(buffer.data() + done, frames, phase, increment);
+  const auto reference = legacyFunc(waveform);
+  double worst = 0.0;
+  for (std::size_t i = 0; i < total; ++i) {
+    const double p = std::fmod(i * increment, 1.0);
+    const bool nearEdge = std::min({p, std::abs(p - 0.5), 1.0 - p}) < 1e-3;
+    if (waveform != osc::Waveform::Sine &&
+        waveform != osc::Waveform::Triangle && nearEdge)
+      continue;
+    worst = std::max(worst, std::abs(buffer[i] - reference(p)));
+  }
+  return worst;
+}
+} // namespace
+
+int main(int argc, char **argv) try {
+  const double seconds = argc >= 2 ? std::strtod(argv[1], nullptr) : 60.0;
+  const std::size_t frames =
+      argc >= 3 ? std::strtoul(argv[2], nullptr, 10) : 256;
+  if (frames == 0)
+    throw std::runtime_error("frames_per_buffer must be positive");
+  const std::size_t samples =
+      static_cast<std::size_t>(seconds * SAMPLE_RATE) / frames * frames;
+
+  std::cout << "oscillator: " << samples << " samples in " << frames
+            << "-frame buffers, best isa " << osc::isaName(osc::bestIsa())
+            << "\n";
+
+  static constexpr osc::Waveform WAVEFORMS[] = {
+      osc::Waveform::Sine, osc::Waveform::Square, osc::Waveform::Sawtooth,
+      osc::Waveform::Triangle};
+  static constexpr osc::Isa ISAS[] = {osc::Isa::Scalar, osc::Isa::Sse,
+                                      osc::Isa::Avx2};
+  BenchReport json("oscillator");
+  double sink = 0.0;
+  for (osc::Waveform waveform : WAVEFORMS) {
+    const std::string name = osc::waveformName(waveform);
+    const Result legacy = runLegacy(legacyFunc(waveform), samples, frames);
+    sink += legacy.checksum;
+    std::cout << osc::waveformName(waveform) << "\n  std::function: "
+              << legacy.nsPerSample << " ns/sample\n";
+    json.add(name + " std::function", legacy.nsPerSample, "ns/sample");
+    for (osc::Isa isa : ISAS) {
+      if (isa > osc::bestIsa())
+        continue;
+      const osc::BlockKernel kernel = osc::kernelFor(waveform, isa);
+      const Result block = runKernel(kernel, samples, frames);
+      sink += block.checksum;
+      std::cout << "  " << osc::isaName(isa) << ": " << block.nsPerSample
+                << " ns/sample (" << legacy.nsPerSample / block.nsPerSample
+                << "x), max error " << maxError(kernel, waveform, frames) << "\n";
+      json.add(name + " " + osc::isaName(isa), block.nsPerSample, "ns/sample");
+    }
+    const Result table =
+        runKernel(osc::wavetableKernel(waveform), samples, frames);
+    sink += table.checksum;
+    std::cout << "  wavetable: " << table.nsPerSample << " ns/sample ("
+              << legacy.nsPerSample / table.nsPerSample << "x)\n";
+    json.add(name + " wavetable", table.nsPerSample, "ns/sample");
+  }
+  json.write();
+  // Printed so the renders cannot be optimised away.
+  std::cout << "checksum " << sink << "\n";
+  return EXIT_SUCCESS;
+} catch (const std::exception &e) {
+  std::cerr << "Error: " << e.what() << '\n';
+  return EXIT_FAILURE;
+}
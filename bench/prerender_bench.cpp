@@ -0,0 +1,111 @@
+// Measures how the parallel pre-render scales with the number of threads on
+// a synthetic song of overlapping chords, and checks that every run matches
+// the serial streaming render sample for sample.
+//
+// Usage: bench_prerender [song_seconds] [max_threads]
+
+#include "benchreport.h"
+#include "dds.h"
+#include "eventsource.h"
+#include "mixer.h"
+#include "oscillator.h"
+#include "prerender.h"
+#include "songrenderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+constexpr double SAMPLE_RATE = 48000.0;
+
+// Four-note chords every 125 ms that ring for half a second, so about
+// sixteen voices sound at once.
+std::vector<SongEvent> syntheticSong(double seconds) {
+  std::vector<SongEvent> events;
+  const std::size_t steps = static_cast<std::size_t>(seconds * 8);
+  for (std::size_t step = 0; step < steps; ++step) {
+    for (int voice = 0; voice < 4; ++voice) {
+      SongEvent event{};
+      event.kind = SongEvent::Kind::Note;
+      event.frequency = 110.0f * (1.0f + 0.25f * ((step + voice * 3) % 17));
+      event.durationUs = 500000;
+      event.delayUs = step != 0 && voice == 0 ? 125000 : 0;
+      events.push_back(event);
+    }
+  }
+  return events;
+}
+
+template <typename Sample>
+void report(BenchReport &json, const char *name,
+            const std::vector<SongEvent> &events, const Mixer &prototype,
+            unsigned maxThreads) {
+  std::vector<Sample> serial;
+  VectorEventSource song(events);
+  Mixer mixer = prototype;
+  auto start = Clock::now();
+  render::renderSong<Sample>(song, mixer, SAMPLE_RATE,
+                             [&](const Sample *samples, std::size_t frames) {
+                               serial.insert(serial.end(), samples,
+                                             samples + frames);
+                             });
+  const double serialSeconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  std::cout << name << "\n  serial: " << serialSeconds << " s\n";
+  json.add(std::string(name) + " serial", serialSeconds, "s");
+
+  VectorEventSource source(events);
+  const render::Timeline timeline = render::timelineOf(source, SAMPLE_RATE);
+  for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+    start = Clock::now();
+    const render::PcmBuffer<Sample> pcm =
+        render::prerender<Sample>(timeline, prototype, threads);
+    const double seconds =
+        std::chrono::duration<double>(Clock::now() - start).count();
+    const bool exact =
+        pcm.frames == serial.size() &&
+        std::memcmp(pcm.samples.get(), serial.data(),
+                    serial.size() * sizeof(Sample)) == 0;
+    std::cout << "  " << threads << " threads: " << seconds << " s, "
+              << serialSeconds / seconds << "x serial, "
+              << (exact ? "bit-exact" : "MISMATCH") << "\n";
+    json.add(std::string(name) + " " + std::to_string(threads) + " threads",
+             seconds, "s");
+    if (!exact)
+      throw std::runtime_error("pre-render differs from the serial render");
+  }
+}
+} // namespace
+
+int main(int argc, char **argv) try {
+  const double songSeconds = argc >= 2 ? std::strtod(argv[1], nullptr) : 600;
+  const unsigned maxThreads =
+      argc >= 3 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10))
+                : std::max(1u, std::thread::hardware_concurrency());
+  if (songSeconds <= 0 || maxThreads == 0)
+    throw std::runtime_error("arguments must be positive");
+
+  const std::vector<SongEvent> events = syntheticSong(songSeconds);
+  std::cout << "prerender: " << songSeconds << " s song, up to " << maxThreads
+            << " threads (" << std::thread::hardware_concurrency()
+            << " hardware)\n";
+  const osc::Waveform waveform = osc::Waveform::Sawtooth;
+  BenchReport json("prerender");
+  report<float>(json, "formula (best isa)", events,
+                Mixer(osc::kernelFor(waveform)), maxThreads);
+  report<int16_t>(json, "dds int16", events,
+                  Mixer(nullptr, osc::dds::lutFor(waveform)), maxThreads);
+  json.write();
+  return EXIT_SUCCESS;
+} catch (const std::exception &e) {
+  std::cerr << "Error: " << e.what() << '\n';
+  return EXIT_FAILURE;
+}
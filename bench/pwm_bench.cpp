@@ -0,0 +1,138 @@
+// Plays one sine note through the PWM engine into a recording instead of
+// the pc speaker, then rebuilds the pulse train from the recorded write
+// times and compares each period's on-time with the duty table. The
+// recording's timestamps have microsecond resolution, so at 20 kHz a period
+// is resolved to about 2% of its length.
+//
+// Usage: bench_pwm [seconds] [pwm_rate_hz] [frequency_hz]
+
+#include "benchreport.h"
+#include "pwmengine.h"
+#include "scheduler.h"
+#include "speaker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+struct Edge {
+  int64_t atNs;
+  bool on;
+};
+
+std::vector<Edge> readEdges(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  std::vector<Edge> edges;
+  Speaker::EventVal event;
+  while (in.read(reinterpret_cast<char *>(&event), sizeof event))
+    edges.push_back({static_cast<int64_t>(event.t_val.tv_sec) * 1000000000LL +
+                         static_cast<int64_t>(event.t_val.tv_usec) * 1000,
+                     event.value != 0});
+  return edges;
+}
+
+// Time the recorded signal spends on within [fromNs, toNs).
+int64_t onTime(const std::vector<Edge> &edges, std::size_t &cursor,
+               int64_t fromNs, int64_t toNs) {
+  while (cursor < edges.size() && edges[cursor].atNs <= fromNs)
+    ++cursor;
+  bool on = cursor > 0 && edges[cursor - 1].on;
+  int64_t total = 0;
+  int64_t at = fromNs;
+  for (std::size_t i = cursor; i < edges.size() && edges[i].atNs < toNs;
+       ++i) {
+    if (on)
+      total += edges[i].atNs - at;
+    at = edges[i].atNs;
+    on = edges[i].on;
+  }
+  if (on)
+    total += toNs - at;
+  return total;
+}
+} // namespace
+
+int main(int argc, char **argv) try {
+  const double seconds = argc >= 2 ? std::strtod(argv[1], nullptr) : 1.0;
+  const unsigned rate =
+      argc >= 3 ? std::strtoul(argv[2], nullptr, 10) : PwmEngine::DEFAULT_RATE;
+  const int frequency = argc >= 4 ? std::atoi(argv[3]) : 440;
+  if (seconds <= 0.0 || rate == 0 || frequency <= 0)
+    throw std::runtime_error("arguments must be positive");
+
+  const PwmEngine::DutyTable table = PwmEngine::dutyTable(
+      frequency, rate, osc::Waveform::Sine, osc::Engine::Formula);
+  const double cents =
+      1200.0 * std::log2(static_cast<double>(table.cycles) * rate /
+                         table.onNs.size() / frequency);
+  std::cout << "pwm: " << frequency << " Hz sine at " << rate
+            << " Hz PWM for " << seconds << " s\n";
+  std::cout << "  duty table: " << table.onNs.size() << " periods for "
+            << table.cycles << " cycles, pitch error " << cents
+            << " cents\n";
+
+  char path[] = "/tmp/bench_pwmXXXXXX";
+  const int fd = mkstemp(path);
+  if (fd == -1)
+    throw std::runtime_error("cannot create a temporary file");
+  close(fd);
+
+  const uint64_t lengthUs = static_cast<uint64_t>(seconds * 1e6);
+  int64_t originNs;
+  PwmEngine::Report report;
+  {
+    Speaker speaker(path);
+    PwmEngine engine(speaker, rate, osc::Waveform::Sine, osc::Engine::Formula);
+    engine.load({{0, frequency}, {lengthUs, 0}});
+    originNs = Scheduler::nowNs() + 10000000; // 10 ms to get going
+    engine.start(originNs);
+    engine.join();
+    report = engine.report();
+    engine.printReport(std::cout);
+  }
+
+  // Compare every period that was not skipped with the table.
+  const std::vector<Edge> edges = readEdges(path);
+  unlink(path);
+  std::vector<double> errors;
+  std::size_t cursor = 0;
+  const uint64_t periods = lengthUs * rate / 1000000;
+  for (uint64_t period = 0; period < periods; ++period) {
+    const int64_t fromNs =
+        originNs + static_cast<int64_t>(period * 1000000000ULL / rate);
+    const int64_t toNs =
+        originNs + static_cast<int64_t>((period + 1) * 1000000000ULL / rate);
+    const double measured =
+        static_cast<double>(onTime(edges, cursor, fromNs, toNs)) /
+        (toNs - fromNs);
+    const double expected =
+        static_cast<double>(table.onNs[period % table.onNs.size()]) /
+        (1000000000LL / rate);
+    errors.push_back(std::abs(measured - expected));
+  }
+  std::sort(errors.begin(), errors.end());
+  std::cout << "  recorded duty error (share of a period): p50 "
+            << errors[(errors.size() - 1) / 2] << ", p99 "
+            << errors[(errors.size() - 1) * 99 / 100] << ", max "
+            << errors.back() << " over " << errors.size() << " periods ("
+            << report.skipped << " skipped)\n";
+  BenchReport json("pwm");
+  json.add("pitch error", cents, "cents");
+  json.add("duty error p50", errors[(errors.size() - 1) / 2], "period");
+  json.add("duty error p99", errors[(errors.size() - 1) * 99 / 100], "period");
+  json.add("duty error max", errors.back(), "period");
+  json.add("skipped", static_cast<double>(report.skipped), "periods");
+  json.write();
+  return EXIT_SUCCESS;
+} catch (const std::exception &e) {
+  std::cerr << "Error: " << e.what() << '\n';
+  return EXIT_FAILURE;
+}
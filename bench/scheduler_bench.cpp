@@ -0,0 +1,78 @@
+// Measures the wake-up jitter of timed sleeps: a run of evenly spaced
+// deadlines is waited for with the Scheduler, sleeping only and with a short
+// busy-wait before each deadline, and with the relative usleep() of the
+// original playback loop, whose lateness piles up over the run.
+//
+// Usage: bench_scheduler [deadlines] [interval_us]
+
+#include "benchreport.h"
+#include "scheduler.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+constexpr uint32_t SPIN_US = 200;
+
+void report(BenchReport &json, const std::string &name,
+            std::vector<double> late) {
+  std::sort(late.begin(), late.end());
+  const double p50 = late[(late.size() - 1) / 2];
+  const double p99 = late[(late.size() - 1) * 99 / 100];
+  std::cout << "  " << name << ": p50 " << p50 << " us, p99 " << p99
+            << " us, max " << late.back() << " us late\n";
+  json.add(name + " p50", p50, "us");
+  json.add(name + " p99", p99, "us");
+  json.add(name + " max", late.back(), "us");
+}
+
+std::vector<double> runScheduler(uint32_t spinUs, std::size_t deadlines,
+                                 uint64_t intervalUs) {
+  std::vector<double> late;
+  late.reserve(deadlines);
+  Scheduler scheduler(spinUs);
+  scheduler.start();
+  for (std::size_t i = 1; i <= deadlines; ++i)
+    late.push_back(scheduler.waitUntil(i * intervalUs) / 1e3);
+  return late;
+}
+
+// Each sleep starts from whenever the previous one ended.
+std::vector<double> runUsleep(std::size_t deadlines, uint64_t intervalUs) {
+  std::vector<double> late;
+  late.reserve(deadlines);
+  const int64_t startNs = Scheduler::nowNs();
+  for (std::size_t i = 1; i <= deadlines; ++i) {
+    usleep(static_cast<useconds_t>(intervalUs));
+    late.push_back((Scheduler::nowNs() - startNs) / 1e3 -
+                   static_cast<double>(i * intervalUs));
+  }
+  return late;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  const std::size_t deadlines =
+      argc >= 2 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+  const uint64_t intervalUs =
+      argc >= 3 ? std::strtoull(argv[2], nullptr, 10) : 1000;
+  if (deadlines == 0 || intervalUs == 0) {
+    std::cerr << "deadlines and interval_us must be positive\n";
+    return EXIT_FAILURE;
+  }
+  std::cout << "scheduler: " << deadlines << " deadlines, one every "
+            << intervalUs << " us\n";
+
+  BenchReport json("scheduler");
+  report(json, "sleep", runScheduler(0, deadlines, intervalUs));
+  report(json, "sleep + " + std::to_string(SPIN_US) + " us spin",
+         runScheduler(SPIN_US, deadlines, intervalUs));
+  report(json, "relative usleep", runUsleep(deadlines, intervalUs));
+  json.write();
+  return EXIT_SUCCESS;
+}
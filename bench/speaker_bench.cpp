@@ -0,0 +1,120 @@
+// Measures how accurately tone changes reach the speaker device, without a
+// pc speaker: the events are recorded to a temporary file and their
+// timestamps compared with the schedule. The timerfd SpeakerEngine is set
+// against the old NotePlayer::play() pattern of a write followed by usleep().
+//
+// Usage: bench_speaker [changes] [interval_us]
+
+#include "benchreport.h"
+#include "scheduler.h"
+#include "speaker.h"
+#include "speakerengine.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+// A change every `intervalUs`; every fourth step also silences and restarts
+// the tone at the same instant, which the engine sends as one write.
+std::vector<ToneChange> timeline(std::size_t changes, uint64_t intervalUs) {
+  std::vector<ToneChange> tones;
+  for (std::size_t i = 0; tones.size() < changes; ++i) {
+    const uint64_t atUs = i * intervalUs;
+    if (i % 4 == 3)
+      tones.push_back({atUs, 0});
+    tones.push_back({atUs, 220 + static_cast<int>(i % 12) * 20});
+  }
+  tones.resize(changes);
+  return tones;
+}
+
+// Lateness of each recorded event against its scheduled time, in us.
+std::vector<double> lateness(const std::string &path,
+                             const std::vector<ToneChange> &tones,
+                             int64_t originNs) {
+  std::ifstream in(path, std::ios::binary);
+  std::vector<double> late;
+  Speaker::EventVal event;
+  while (late.size() < tones.size() &&
+         in.read(reinterpret_cast<char *>(&event), sizeof event)) {
+    const int64_t atNs = static_cast<int64_t>(event.t_val.tv_sec) *
+                             1000000000LL +
+                         static_cast<int64_t>(event.t_val.tv_usec) * 1000;
+    late.push_back((atNs - originNs) / 1e3 -
+                   static_cast<double>(tones[late.size()].atUs));
+  }
+  if (late.size() != tones.size())
+    throw std::runtime_error("recording is incomplete: " + path);
+  return late;
+}
+
+void report(BenchReport &json, const std::string &name,
+            std::vector<double> late) {
+  const double drift = late.back();
+  std::sort(late.begin(), late.end());
+  json.add(name + " p50", late[(late.size() - 1) / 2], "us");
+  json.add(name + " p99", late[(late.size() - 1) * 99 / 100], "us");
+  json.add(name + " max", late.back(), "us");
+  json.add(name + " drift", drift, "us");
+  std::cout << "  " << name << ": p50 " << late[(late.size() - 1) / 2]
+            << " us, p99 " << late[(late.size() - 1) * 99 / 100]
+            << " us, max " << late.back() << " us, drift at end " << drift
+            << " us\n";
+}
+} // namespace
+
+int main(int argc, char **argv) try {
+  const std::size_t changes =
+      argc >= 2 ? std::strtoul(argv[1], nullptr, 10) : 400;
+  const uint64_t intervalUs =
+      argc >= 3 ? std::strtoul(argv[2], nullptr, 10) : 5000;
+  if (changes == 0 || intervalUs == 0)
+    throw std::runtime_error("arguments must be positive");
+
+  char path[] = "/tmp/bench_speakerXXXXXX";
+  const int fd = mkstemp(path);
+  if (fd == -1)
+    throw std::runtime_error("cannot create a temporary file");
+  close(fd);
+  const std::vector<ToneChange> tones = timeline(changes, intervalUs);
+  std::cout << "speaker: " << changes << " tone changes, one step every "
+            << intervalUs << " us, recorded to " << path << "\n";
+
+  BenchReport json("speaker");
+  {
+    Speaker speaker(path);
+    SpeakerEngine engine(speaker);
+    const int64_t originNs = Scheduler::nowNs() + 10000000; // 10 ms to get going
+    engine.start(tones, originNs);
+    engine.join();
+    report(json, "timerfd engine", lateness(path, tones, originNs));
+    const SpeakerEngine::Report r = engine.report();
+    std::cout << "    " << r.changes << " changes in " << r.writes
+              << " writes\n";
+  }
+  {
+    // The write-then-sleep loop NotePlayer::play() uses: each sleep starts
+    // after the write, so every step's overhead adds up.
+    Speaker speaker(path);
+    const int64_t originNs = Scheduler::nowNs();
+    for (std::size_t i = 0; i < tones.size(); ++i) {
+      speaker.sendTone(tones[i].frequency);
+      if (i + 1 < tones.size())
+        usleep(static_cast<useconds_t>(tones[i + 1].atUs - tones[i].atUs));
+    }
+    report(json, "write + usleep", lateness(path, tones, originNs));
+  }
+  unlink(path);
+  json.write();
+  return EXIT_SUCCESS;
+} catch (const std::exception &e) {
+  std::cerr << "Error: " << e.what() << '\n';
+  return EXIT_FAILURE;
+}
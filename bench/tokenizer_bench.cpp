@@ -0,0 +1,121 @@
+// Compares the iostream token extraction used by the original playback loop
+// against the mmap-backed ScoreTokenizer on a synthetic score, then times
+// the full parse into playback events that replaced that loop.
+//
+// Usage: bench_tokenizer [size_in_MB] [score_path]
+
+#include "benchreport.h"
+#include "mappedfile.h"
+#include "scoretokenizer.h"
+#include "song.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+void writeSyntheticScore(const std::string &path, std::size_t targetBytes) {
+  static constexpr const char *NOTES[] = {"C", "C#", "D",  "Eb", "E",  "F",
+                                          "F#", "G", "Ab", "A",  "Bb", "B"};
+  static constexpr const char *VALUES[] = {"w", "h", "q", "e", "s", "t", "sf"};
+  std::ofstream out(path);
+  if (!out.is_open()) {
+    throw std::runtime_error("Failed to create " + path);
+  }
+  std::size_t written = 0;
+  std::size_t i = 0;
+  char line[32];
+  while (written < targetBytes) {
+    int len;
+    if (i % 97 == 0)
+      len = std::snprintf(line, sizeof(line), "bpm %zu\n", 80 + i % 160);
+    else if (i % 5 == 0)
+      len = std::snprintf(line, sizeof(line), "P %s\n", VALUES[i % 7]);
+    else
+      len = std::snprintf(line, sizeof(line), "%s %zu %s\n", NOTES[i % 12],
+                          2 + i % 5, VALUES[i % 7]);
+    out.write(line, len);
+    written += static_cast<std::size_t>(len);
+    ++i;
+  }
+}
+
+// Mirrors the extraction pattern of the old main.cpp loop.
+std::size_t tokenizeIfstream(const std::string &path) {
+  std::ifstream input(path);
+  std::string note;
+  std::string value;
+  int number = 0;
+  std::size_t tokens = 0;
+  while (input >> note) {
+    if (note == "bpm") {
+      input >> number;
+      tokens += 2;
+    } else if (note == "P") {
+      input >> value;
+      tokens += 2;
+    } else {
+      input >> number >> value;
+      tokens += 3;
+    }
+  }
+  return tokens;
+}
+
+std::size_t tokenizeMapped(const std::string &path) {
+  const MappedFile file(path);
+  ScoreTokenizer tokenizer(file.view());
+  ScoreTokenizer::Token token;
+  std::size_t tokens = 0;
+  while (tokenizer.next(token))
+    ++tokens;
+  return tokens;
+}
+
+std::size_t compileMapped(const std::string &path) {
+  return SongCompiler().compileFile(path).size();
+}
+
+template <typename Fn>
+void report(BenchReport &json, const char *name, const char *counted,
+            std::size_t bytes, Fn &&fn) {
+  const auto start = Clock::now();
+  const std::size_t count = fn();
+  const double seconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  std::cout << name << ": " << count << " " << counted << " in "
+            << seconds * 1e3 << " ms, " << (bytes / 1e6) / seconds
+            << " MB/s\n";
+  json.add(name, (bytes / 1e6) / seconds, "MB/s");
+}
+} // namespace
+
+int main(int argc, char **argv) try {
+  const std::size_t megabytes = argc >= 2 ? std::strtoul(argv[1], nullptr, 10)
+                                          : 100;
+  const std::string path = argc >= 3 ? argv[2] : "/tmp/bench_score.txt";
+
+  writeSyntheticScore(path, megabytes * 1000 * 1000);
+  const std::size_t bytes = MappedFile(path).size();
+  std::cout << "score: " << path << " (" << bytes / 1e6 << " MB)\n";
+
+  BenchReport json("tokenizer");
+  report(json, "ifstream", "tokens", bytes,
+         [&] { return tokenizeIfstream(path); });
+  report(json, "mmap tokenizer", "tokens", bytes,
+         [&] { return tokenizeMapped(path); });
+  report(json, "song compiler", "events", bytes,
+         [&] { return compileMapped(path); });
+  json.write();
+
+  std::remove(path.c_str());
+  return EXIT_SUCCESS;
+} catch (const std::exception &e) {
+  std::cerr << "Error: " << e.what() << '\n';
+  return EXIT_FAILURE;
+}
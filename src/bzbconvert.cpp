@@ -0,0 +1,36 @@
+#include "include/Song/bzbformat.h"
+#include "include/Song/song.h"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+void printUsage(const char *progName) {
+  std::cerr << "Usage: " << progName << " <input.txt> <output.bzb>\n";
+}
+
+int main(int argc, char **argv) try {
+  if (argc < 3) {
+    printUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  const std::string inputFileName = argv[1];
+  const std::string outputFileName = argv[2];
+
+  std::vector<SongEvent> song;
+  try {
+    song = SongCompiler().compileFile(inputFileName);
+  } catch (const SongParseError &e) {
+    std::cerr << inputFileName << ":" << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+  writeBzb(song, outputFileName);
+  std::cout << "Wrote " << song.size() << " events to " << outputFileName
+            << "\n";
+  return EXIT_SUCCESS;
+} catch (const std::exception &e) {
+  std::cerr << "Error: " << e.what() << '\n';
+  return EXIT_FAILURE;
+}
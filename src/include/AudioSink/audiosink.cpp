@@ -0,0 +1,19 @@
+#include "audiosink.h"
+#include "pacedsink.h"
+#include "portaudiosink.h"
+
+#include <cstdint>
+
+std::unique_ptr<AudioSink> makeAudioSink(const std::string &spec,
+                                         double sampleRate,
+                                         AudioSink::Format format) {
+  if (spec == "portaudio")
+    return std::make_unique<PortAudioSink>(sampleRate, format);
+  if (spec == "null")
+    return std::make_unique<NullSink>(sampleRate, format);
+  return std::make_unique<PipeSink>(spec, sampleRate, format);
+}
+
+std::size_t sampleBytes(AudioSink::Format format) {
+  return format == AudioSink::Format::Int16 ? sizeof(int16_t) : sizeof(float);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "../Scheduler/scheduler.h"
+#include "../Telemetry/callbacktelemetry.h"
+#include "../Telemetry/rtcheck.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// Where rendered audio goes. A sink owns the thread that asks for audio and
+// calls the render function once per buffer, so the only indirection is one
+// call per buffer; the samples themselves are written straight into the
+// sink's memory by the mixer. Every call is timed into the sink's
+// CallbackTelemetry.
+class AudioSink {
+public:
+  enum class Format { Float32, Int16 };
+  // Fills `frames` mono samples of the sink's format at `out`. Runs on the
+  // sink's thread, which must never block waiting for the caller.
+  using RenderFn = void (*)(void *out, unsigned long frames, void *context);
+
+  virtual ~AudioSink() = default;
+  // Starts pulling audio. Throws std::runtime_error if the output fails.
+  virtual void start(RenderFn render, void *context) = 0;
+  // Stops pulling audio; once it returns, render is no longer running.
+  virtual void stop() = 0;
+  // Audio a sink renders ahead of what is audible. Schedules must start at
+  // least this far ahead of the rendered position to be heard on time.
+  virtual double bufferSeconds() const = 0;
+  virtual std::string description() const = 0;
+
+  const CallbackTelemetry &telemetry() const { return telemetry_; }
+
+protected:
+  explicit AudioSink(double sampleRate) : telemetry_(sampleRate) {}
+
+  void setRender(RenderFn render, void *context) {
+    render_ = render;
+    context_ = context;
+  }
+  // What a backend calls for each buffer. `underflow` reports that the
+  // output ran dry before this buffer.
+  void pull(void *out, unsigned long frames, bool underflow) {
+    const int64_t begin = Scheduler::nowNs();
+    {
+      rtcheck::CallbackScope scope;
+      render_(out, frames, context_);
+    }
+    telemetry_.record(frames, Scheduler::nowNs() - begin, underflow);
+  }
+
+private:
+  RenderFn render_ = nullptr;
+  void *context_ = nullptr;
+  CallbackTelemetry telemetry_;
+};
+
+// `spec` is "portaudio" (the default sound card), "null" (discarded, paced
+// in real time) or a path to write raw PCM to; "-" is standard output.
+// Throws std::runtime_error if the sink cannot be opened.
+std::unique_ptr<AudioSink> makeAudioSink(const std::string &spec,
+                                         double sampleRate,
+                                         AudioSink::Format format);
+
+std::size_t sampleBytes(AudioSink::Format format);
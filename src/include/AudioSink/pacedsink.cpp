@@ -0,0 +1,100 @@
+#include "pacedsink.h"
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+
+PacedSink::PacedSink(double sampleRate, Format format, std::size_t frames)
+    : AudioSink(sampleRate), sampleRate_(sampleRate), frames_(frames),
+      buffer_(frames * sampleBytes(format)) {}
+
+PacedSink::~PacedSink() { stop(); }
+
+void PacedSink::start(RenderFn render, void *context) {
+  setRender(render, context);
+  running_.store(true, std::memory_order_release);
+  thread_ = std::thread(&PacedSink::run, this);
+}
+
+void PacedSink::stop() {
+  running_.store(false, std::memory_order_release);
+  if (thread_.joinable())
+    thread_.join();
+}
+
+void PacedSink::run() {
+  using Clock = std::chrono::steady_clock;
+  const auto period = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(frames_ / sampleRate_));
+  Clock::time_point next = Clock::now();
+  bool late = false;
+  while (running_.load(std::memory_order_acquire)) {
+    pull(buffer_.data(), static_cast<unsigned long>(frames_), late);
+    deliver(buffer_.data(), buffer_.size());
+    next += period;
+    const Clock::time_point now = Clock::now();
+    late = now > next;
+    if (now > next + period)
+      next = now;
+    std::this_thread::sleep_until(next);
+  }
+}
+
+NullSink::NullSink(double sampleRate, Format format)
+    : PacedSink(sampleRate, format, FRAMES) {}
+
+// The thread calls deliver(), so it has to stop before this class is gone.
+NullSink::~NullSink() { stop(); }
+
+void NullSink::deliver(const char * /*samples*/, std::size_t /*bytes*/) {}
+
+PipeSink::PipeSink(const std::string &path, double sampleRate, Format format)
+    : PacedSink(sampleRate, format, FRAMES), path_(path), fd_(-1) {
+  if (path != "-") {
+    fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ == -1)
+      throw std::runtime_error("Failed to open audio output " + path);
+  } else {
+    // Standard output now belongs to the audio: keep a descriptor for it and
+    // point fd 1 at the terminal, so text and the curses screen stay out of
+    // the stream.
+    path_ = "stdout";
+    std::fflush(stdout);
+    fd_ = dup(STDOUT_FILENO);
+    int terminal = open("/dev/tty", O_WRONLY);
+    if (terminal == -1)
+      terminal = open("/dev/null", O_WRONLY);
+    if (fd_ == -1 || terminal == -1 || dup2(terminal, STDOUT_FILENO) == -1)
+      throw std::runtime_error("Failed to take over standard output");
+    close(terminal);
+  }
+  // A reader that exits must not kill the player; write() reports EPIPE.
+  std::signal(SIGPIPE, SIG_IGN);
+  // Room for a whole buffer keeps each write to a pipe in one piece; a pipe
+  // that is already larger is left alone. Files refuse both, which is fine.
+  const int wanted = static_cast<int>(FRAMES * sampleBytes(format));
+  const int current = fcntl(fd_, F_GETPIPE_SZ);
+  if (current != -1 && current < wanted)
+    fcntl(fd_, F_SETPIPE_SZ, wanted);
+}
+
+PipeSink::~PipeSink() {
+  stop();
+  close(fd_);
+}
+
+void PipeSink::deliver(const char *samples, std::size_t bytes) {
+  while (bytes != 0 && !failed_) {
+    const ssize_t written = write(fd_, samples, bytes);
+    if (written == -1) {
+      failed_ = errno != EINTR;
+      continue;
+    }
+    samples += written;
+    bytes -= static_cast<std::size_t>(written);
+  }
+}
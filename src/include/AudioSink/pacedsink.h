@@ -0,0 +1,74 @@
+#pragma once
+
+#include "audiosink.h"
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Sinks without a device clock of their own. A thread renders one buffer at
+// the start of each buffer period of a simulated clock running at the
+// sample rate, exactly as a sound card would ask for it, and hands it on.
+// A buffer rendered after its period began counts as an underflow; if
+// delivering falls a whole period behind, the clock restarts from the
+// current time instead of rendering a burst to catch up.
+class PacedSink : public AudioSink {
+public:
+  ~PacedSink() override;
+
+  void start(RenderFn render, void *context) override;
+  void stop() override;
+  double bufferSeconds() const override { return frames_ / sampleRate_; }
+
+protected:
+  PacedSink(double sampleRate, Format format, std::size_t frames);
+  // Called on the sink's thread with each rendered buffer.
+  virtual void deliver(const char *samples, std::size_t bytes) = 0;
+
+private:
+  void run();
+
+  double sampleRate_;
+  std::size_t frames_;
+  std::vector<char> buffer_; // the mixer renders straight into this
+  std::atomic<bool> running_{false};
+  std::thread thread_;
+};
+
+// Throws the audio away; for benchmarking synthesis without hardware.
+class NullSink final : public PacedSink {
+public:
+  static constexpr std::size_t FRAMES = 256;
+
+  NullSink(double sampleRate, Format format);
+  ~NullSink() override;
+  std::string description() const override { return "null"; }
+
+private:
+  void deliver(const char *samples, std::size_t bytes) override;
+};
+
+// Writes raw native-endian PCM, mono, to a file, a FIFO or standard output,
+// for other local processes to play or analyse. Each buffer is large and
+// goes out in one write() from the memory it was rendered in.
+class PipeSink final : public PacedSink {
+public:
+  static constexpr std::size_t FRAMES = 4096;
+
+  // "-" is standard output, after which fd 1 writes to the terminal.
+  // Opening a FIFO waits for its reader.
+  PipeSink(const std::string &path, double sampleRate, Format format);
+  ~PipeSink() override;
+  PipeSink(const PipeSink &) = delete;
+  PipeSink &operator=(const PipeSink &) = delete;
+  std::string description() const override { return "pcm to " + path_; }
+
+private:
+  void deliver(const char *samples, std::size_t bytes) override;
+
+  std::string path_;
+  int fd_;
+  bool failed_ = false; // the reader went away; later buffers are dropped
+};
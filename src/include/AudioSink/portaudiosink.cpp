@@ -0,0 +1,74 @@
+#include "portaudiosink.h"
+
+#include <stdexcept>
+
+PortAudioSink::PortAudioSink(double sampleRate, Format format)
+    : AudioSink(sampleRate), sampleRate_(sampleRate), format_(format) {
+  if (Pa_Initialize() != paNoError)
+    throw std::runtime_error("PortAudio initialization failed");
+}
+
+PortAudioSink::~PortAudioSink() {
+  stop();
+  Pa_Terminate();
+}
+
+void PortAudioSink::start(RenderFn render, void *context) {
+  setRender(render, context);
+
+  PaStreamParameters outputParameters;
+  outputParameters.device = Pa_GetDefaultOutputDevice();
+  if (outputParameters.device == paNoDevice)
+    throw std::runtime_error("No default output device");
+  outputParameters.channelCount = 1;
+  outputParameters.sampleFormat =
+      format_ == Format::Int16 ? paInt16 : paFloat32;
+  outputParameters.suggestedLatency =
+      Pa_GetDeviceInfo(outputParameters.device)->defaultLowOutputLatency;
+  outputParameters.hostApiSpecificStreamInfo = nullptr;
+
+  PaError err = Pa_OpenStream(&stream_, nullptr, &outputParameters,
+                              sampleRate_, paFramesPerBufferUnspecified,
+                              paClipOff, callback, this);
+  if (err != paNoError) {
+    stream_ = nullptr;
+    throw std::runtime_error("Failed to open stream");
+  }
+
+  err = Pa_StartStream(stream_);
+  if (err != paNoError) {
+    Pa_CloseStream(stream_);
+    stream_ = nullptr;
+    throw std::runtime_error("Failed to start stream");
+  }
+}
+
+void PortAudioSink::stop() {
+  if (stream_) {
+    Pa_StopStream(stream_);
+    Pa_CloseStream(stream_);
+    stream_ = nullptr;
+  }
+}
+
+// The device's own latency plus the buffer the callback is filling. PortAudio
+// picks the buffer size, so until the first callback reports it the latency
+// stands in for it too.
+double PortAudioSink::bufferSeconds() const {
+  if (stream_ == nullptr)
+    return 0.0;
+  const PaStreamInfo *info = Pa_GetStreamInfo(stream_);
+  const double latency = info != nullptr ? info->outputLatency : 0.0;
+  const unsigned long frames = telemetry().snapshot().lastFrames;
+  return latency + (frames != 0 ? frames / sampleRate_ : latency);
+}
+
+int PortAudioSink::callback(const void * /*inputBuffer*/, void *outputBuffer,
+                            unsigned long framesPerBuffer,
+                            const PaStreamCallbackTimeInfo * /*timeInfo*/,
+                            PaStreamCallbackFlags statusFlags,
+                            void *userData) {
+  static_cast<PortAudioSink *>(userData)->pull(
+      outputBuffer, framesPerBuffer, (statusFlags & paOutputUnderflow) != 0);
+  return paContinue;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "audiosink.h"
+
+#include <portaudio.h>
+
+// The default sound card through PortAudio. PortAudio's own thread asks for
+// each buffer; its callback forwards straight to the render function.
+class PortAudioSink : public AudioSink {
+public:
+  // Throws std::runtime_error if PortAudio or the device is unavailable.
+  PortAudioSink(double sampleRate, Format format);
+  ~PortAudioSink() override;
+  PortAudioSink(const PortAudioSink &) = delete;
+  PortAudioSink &operator=(const PortAudioSink &) = delete;
+
+  void start(RenderFn render, void *context) override;
+  void stop() override;
+  double bufferSeconds() const override;
+  std::string description() const override { return "portaudio"; }
+
+private:
+  static int callback(const void *inputBuffer, void *outputBuffer,
+                      unsigned long framesPerBuffer,
+                      const PaStreamCallbackTimeInfo *timeInfo,
+                      PaStreamCallbackFlags statusFlags, void *userData);
+
+  PaStream *stream_ = nullptr;
+  double sampleRate_;
+  Format format_;
+};
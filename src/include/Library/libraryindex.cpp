@@ -0,0 +1,292 @@
+#include "libraryindex.h"
+#include "../Song/eventsource.h"
+#include "../Song/mappedfile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+static_assert(std::endian::native == std::endian::little,
+              ".bzi files are read and written in little-endian order");
+
+namespace fs = std::filesystem;
+
+namespace {
+bool isScore(const fs::path &path) {
+  const std::string extension = path.extension().string();
+  return extension == ".txt" || extension == ".bzb" || extension == ".mid" ||
+         extension == ".midi";
+}
+
+int64_t mtimeNs(const fs::directory_entry &entry) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             entry.last_write_time().time_since_epoch())
+      .count();
+}
+
+template <typename T> void writeRaw(std::ofstream &out, const T &value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+} // namespace
+
+SongStats analyzeSong(const std::string &path) {
+  // Sample rate only affects durationSamples, which is not used here.
+  const auto song =
+      openSong(path, 48000.0, pitch::EQUAL_TEMPERAMENT, /*stream=*/false);
+  SongStats stats;
+  SongEvent event;
+  uint64_t onsetUs = 0;
+  uint64_t endUs = 0;
+  bool first = true;
+  while (song->next(event)) {
+    onsetUs += event.delayUs;
+    endUs = std::max(endUs, onsetUs + event.durationUs);
+    stats.minBpm = first ? event.bpm : std::min(stats.minBpm, event.bpm);
+    stats.maxBpm = std::max(stats.maxBpm, event.bpm);
+    first = false;
+    if (event.kind != SongEvent::Kind::Note)
+      continue;
+    stats.lowestMidi = stats.noteCount == 0
+                           ? event.midi
+                           : std::min(stats.lowestMidi, event.midi);
+    stats.highestMidi = std::max(stats.highestMidi, event.midi);
+    ++stats.noteCount;
+  }
+  stats.lengthMs = static_cast<uint32_t>(
+      std::min<uint64_t>((endUs + 500) / 1000, UINT32_MAX));
+  return stats;
+}
+
+bool SongQuery::matches(const SongStats &stats) const {
+  if (!stats.readable)
+    return false;
+  if (stats.lengthMs < minLengthMs || stats.lengthMs > maxLengthMs ||
+      stats.noteCount < minNotes || stats.noteCount > maxNotes)
+    return false;
+  // An empty song has no tempo or pitch to rule it out.
+  if (stats.maxBpm != 0 && (stats.minBpm < minBpm || stats.maxBpm > maxBpm))
+    return false;
+  return stats.noteCount == 0 ||
+         (stats.lowestMidi >= lowestMidi && stats.highestMidi <= highestMidi);
+}
+
+LibraryIndex LibraryIndex::load(const std::string &path) {
+  LibraryIndex index;
+  std::error_code ec;
+  if (!fs::exists(path, ec))
+    return index;
+  const MappedFile file(path);
+  if (file.size() < sizeof(IndexHeader) ||
+      std::memcmp(file.data(), bzi::MAGIC, sizeof(bzi::MAGIC)) != 0)
+    throw std::runtime_error("Not a song index: " + path);
+  IndexHeader header;
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (header.version != bzi::VERSION)
+    throw std::runtime_error("Unsupported song index version " +
+                             std::to_string(header.version));
+  const std::size_t recordEnd =
+      std::size_t{header.recordOffset} +
+      std::size_t{header.entryCount} * sizeof(IndexRecord);
+  const std::size_t pathEnd =
+      std::size_t{header.pathOffset} + header.pathBytes;
+  if (header.recordOffset < header.headerSize || recordEnd > file.size() ||
+      pathEnd > file.size())
+    throw std::runtime_error("Truncated song index: " + path);
+
+  const char *paths = file.data() + header.pathOffset;
+  index.entries_.reserve(header.entryCount);
+  for (uint32_t i = 0; i < header.entryCount; ++i) {
+    IndexRecord record;
+    std::memcpy(&record,
+                file.data() + header.recordOffset + i * sizeof(IndexRecord),
+                sizeof(record));
+    if (std::size_t{record.pathOffset} + record.pathLength > header.pathBytes)
+      throw std::runtime_error("Corrupt song index: " + path);
+    Entry entry;
+    entry.path.assign(paths + record.pathOffset, record.pathLength);
+    entry.mtimeNs = record.mtimeNs;
+    entry.size = record.size;
+    entry.stats.lengthMs = record.lengthMs;
+    entry.stats.noteCount = record.noteCount;
+    entry.stats.minBpm = record.minBpm;
+    entry.stats.maxBpm = record.maxBpm;
+    entry.stats.lowestMidi = record.lowestMidi;
+    entry.stats.highestMidi = record.highestMidi;
+    entry.stats.readable = (record.flags & bzi::UNREADABLE) == 0;
+    index.entries_.push_back(std::move(entry));
+  }
+  if (!std::is_sorted(index.entries_.begin(), index.entries_.end(),
+                      [](const Entry &a, const Entry &b) {
+                        return a.path < b.path;
+                      }))
+    throw std::runtime_error("Corrupt song index: " + path);
+  return index;
+}
+
+void LibraryIndex::save(const std::string &path) const {
+  std::vector<IndexRecord> records;
+  records.reserve(entries_.size());
+  std::size_t pathBytes = 0;
+  for (const Entry &entry : entries_) {
+    IndexRecord record{};
+    record.mtimeNs = entry.mtimeNs;
+    record.size = entry.size;
+    record.pathOffset = static_cast<uint32_t>(pathBytes);
+    record.pathLength = static_cast<uint32_t>(entry.path.size());
+    record.lengthMs = entry.stats.lengthMs;
+    record.noteCount = entry.stats.noteCount;
+    record.minBpm = entry.stats.minBpm;
+    record.maxBpm = entry.stats.maxBpm;
+    record.lowestMidi = entry.stats.lowestMidi;
+    record.highestMidi = entry.stats.highestMidi;
+    record.flags = entry.stats.readable ? 0 : bzi::UNREADABLE;
+    records.push_back(record);
+    pathBytes += entry.path.size();
+  }
+  if (pathBytes > UINT32_MAX)
+    throw std::runtime_error("Song index too large");
+
+  IndexHeader header{};
+  std::memcpy(header.magic, bzi::MAGIC, sizeof(header.magic));
+  header.version = bzi::VERSION;
+  header.headerSize = sizeof(IndexHeader);
+  header.entryCount = static_cast<uint32_t>(records.size());
+  header.recordOffset = sizeof(IndexHeader);
+  header.pathOffset = static_cast<uint32_t>(
+      header.recordOffset + records.size() * sizeof(IndexRecord));
+  header.pathBytes = static_cast<uint32_t>(pathBytes);
+
+  const std::string temporary = path + ".tmp";
+  {
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+      throw std::runtime_error("Failed to create file: " + temporary);
+    writeRaw(out, header);
+    out.write(reinterpret_cast<const char *>(records.data()),
+              static_cast<std::streamsize>(records.size() *
+                                           sizeof(IndexRecord)));
+    for (const Entry &entry : entries_)
+      out.write(entry.path.data(),
+                static_cast<std::streamsize>(entry.path.size()));
+    if (!out)
+      throw std::runtime_error("Failed to write file: " + temporary);
+  }
+  if (std::rename(temporary.c_str(), path.c_str()) != 0)
+    throw std::runtime_error("Failed to replace file: " + path);
+}
+
+LibraryIndex::ScanReport LibraryIndex::scan(const std::string &root,
+                                            unsigned threads) {
+  const fs::path base = fs::absolute(root).lexically_normal();
+  std::string prefix = base.string();
+  if (prefix.empty() || prefix.back() != '/')
+    prefix += '/';
+
+  std::unordered_map<std::string_view, const Entry *> known;
+  known.reserve(entries_.size());
+  for (const Entry &entry : entries_)
+    known.emplace(entry.path, &entry);
+
+  // Walk the tree and stat every score; only what changed gets parsed.
+  ScanReport report{};
+  std::vector<Entry> found;
+  std::vector<std::size_t> changed;
+  std::size_t stillThere = 0; // indexed before and found again
+  std::error_code ec;
+  for (fs::recursive_directory_iterator
+           it(base, fs::directory_options::skip_permission_denied, ec),
+       end;
+       it != end; it.increment(ec)) {
+    if (ec)
+      break;
+    if (!it->is_regular_file(ec) || !isScore(it->path()))
+      continue;
+    Entry entry;
+    entry.path = it->path().lexically_normal().string();
+    entry.mtimeNs = mtimeNs(*it);
+    entry.size = it->file_size(ec);
+    if (ec)
+      continue;
+    const auto previous = known.find(entry.path);
+    stillThere += previous != known.end() ? 1 : 0;
+    if (previous != known.end() &&
+        previous->second->mtimeNs == entry.mtimeNs &&
+        previous->second->size == entry.size) {
+      entry.stats = previous->second->stats;
+    } else {
+      changed.push_back(found.size());
+    }
+    found.push_back(std::move(entry));
+  }
+  if (ec)
+    throw std::runtime_error("Failed to scan " + base.string() + ": " +
+                             ec.message());
+
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  std::atomic<std::size_t> nextFile{0};
+  std::atomic<std::size_t> unreadable{0};
+  auto work = [&] {
+    for (std::size_t i = nextFile.fetch_add(1); i < changed.size();
+         i = nextFile.fetch_add(1)) {
+      Entry &entry = found[changed[i]];
+      try {
+        entry.stats = analyzeSong(entry.path);
+      } catch (const std::exception &) {
+        // Kept, so that the file is not parsed again until it changes.
+        entry.stats = SongStats{};
+        entry.stats.readable = false;
+        unreadable.fetch_add(1);
+      }
+    }
+  };
+  std::vector<std::thread> workers;
+  const std::size_t helpers =
+      std::min<std::size_t>(threads, changed.size()) -
+      (changed.empty() ? 0 : 1);
+  for (std::size_t i = 0; i < helpers; ++i)
+    workers.emplace_back(work);
+  work();
+  for (std::thread &worker : workers)
+    worker.join();
+
+  // Merge: entries outside the root stay, those under it are replaced.
+  std::vector<Entry> merged;
+  merged.reserve(entries_.size() + found.size());
+  std::size_t underRoot = 0;
+  for (Entry &entry : entries_) {
+    if (entry.path.starts_with(prefix))
+      ++underRoot;
+    else
+      merged.push_back(std::move(entry));
+  }
+  report.files = found.size();
+  report.analyzed = changed.size();
+  report.unreadable = unreadable.load();
+  report.removed = underRoot - stillThere;
+  for (Entry &entry : found)
+    merged.push_back(std::move(entry));
+  std::sort(merged.begin(), merged.end(),
+            [](const Entry &a, const Entry &b) { return a.path < b.path; });
+  entries_ = std::move(merged);
+  return report;
+}
+
+std::vector<const LibraryIndex::Entry *>
+LibraryIndex::query(const SongQuery &query) const {
+  std::vector<const Entry *> matches;
+  for (const Entry &entry : entries_)
+    if (query.matches(entry.stats))
+      matches.push_back(&entry);
+  return matches;
+}
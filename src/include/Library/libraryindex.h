@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Statistics of one song, as worked out by playing its events through the
+// same parser, note and duration tables as the players.
+struct SongStats {
+  uint32_t lengthMs = 0; // to the end of the last note or rest
+  uint32_t noteCount = 0;
+  uint16_t minBpm = 0;
+  uint16_t maxBpm = 0;
+  uint8_t lowestMidi = 0; // only meaningful when noteCount > 0
+  uint8_t highestMidi = 0;
+  bool readable = true; // false: the file failed to parse
+};
+
+// Reads a score (text, .bzb or MIDI) to the end; throws on malformed input.
+SongStats analyzeSong(const std::string &path);
+
+// Inclusive ranges; the defaults match every readable song. A song matches
+// when all of its tempos and all of its notes fall inside the given ranges.
+struct SongQuery {
+  uint32_t minLengthMs = 0;
+  uint32_t maxLengthMs = UINT32_MAX;
+  uint16_t minBpm = 0;
+  uint16_t maxBpm = UINT16_MAX;
+  uint8_t lowestMidi = 0;
+  uint8_t highestMidi = 127;
+  uint32_t minNotes = 0;
+  uint32_t maxNotes = UINT32_MAX;
+
+  bool matches(const SongStats &stats) const;
+};
+
+// .bzi song index layout (little-endian):
+//
+//   IndexHeader                     24 bytes
+//   IndexRecord[entryCount]         40 bytes each, sorted by path
+//   path table                      the paths, back to back, unterminated
+//
+// Each record carries the file's mtime and size when it was analysed, so a
+// re-scan only reads the files that changed since.
+namespace bzi {
+inline constexpr char MAGIC[4] = {'B', 'Z', 'I', '\0'};
+inline constexpr uint16_t VERSION = 1;
+inline constexpr uint8_t UNREADABLE = 0x01; // IndexRecord::flags
+} // namespace bzi
+
+struct IndexHeader {
+  char magic[4];
+  uint16_t version;
+  uint16_t headerSize;
+  uint32_t entryCount;
+  uint32_t recordOffset;
+  uint32_t pathOffset;
+  uint32_t pathBytes;
+};
+static_assert(sizeof(IndexHeader) == 24);
+
+struct IndexRecord {
+  int64_t mtimeNs;
+  uint64_t size;
+  uint32_t pathOffset; // into the path table
+  uint32_t pathLength;
+  uint32_t lengthMs;
+  uint32_t noteCount;
+  uint16_t minBpm;
+  uint16_t maxBpm;
+  uint8_t lowestMidi;
+  uint8_t highestMidi;
+  uint8_t flags;
+  uint8_t reserved;
+};
+static_assert(sizeof(IndexRecord) == 40);
+
+class LibraryIndex {
+public:
+  struct Entry {
+    std::string path; // absolute
+    int64_t mtimeNs;
+    uint64_t size;
+    SongStats stats;
+  };
+
+  struct ScanReport {
+    std::size_t files;      // scores found under the root
+    std::size_t analyzed;   // new or changed since the last scan
+    std::size_t unreadable; // of those, the ones that failed to parse
+    std::size_t removed;    // entries whose file is gone
+  };
+
+  // A missing file gives an empty index; a corrupt one throws.
+  static LibraryIndex load(const std::string &path);
+  // Written to a temporary file first, so a reader never sees half an index.
+  void save(const std::string &path) const;
+
+  // Walks `root` for .txt, .bzb, .mid and .midi files and analyses the new
+  // and changed ones on `threads` threads, 0 meaning every hardware thread.
+  // Entries from other roots are kept.
+  ScanReport scan(const std::string &root, unsigned threads = 0);
+
+  std::vector<const Entry *> query(const SongQuery &query) const;
+  const std::vector<Entry> &entries() const { return entries_; }
+
+private:
+  std::vector<Entry> entries_; // sorted by path
+};
@@ -1,6 +1,8 @@
 #include "NcursesDrawer.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
 static constexpr char CHAR_NOTE_STEM_STD = '|';
 static constexpr char CHAR_NOTE_STEM_FRC = '\\';
 static constexpr char CHAR_NOTE_HEAD_BLANK = 'O';
@@ -9,35 +11,77 @@ static constexpr char CHAR_NOTE_HEAD_S = '#';
 static constexpr char CHAR_NOTE_HEAD_F = 'b';
 static constexpr char CHAR_STAFF = '_';
 NcursesDrawer::NcursesDrawer()
-    : m_notePositionX(1) // Start notes from column 1
-{}
+    : m_notePositionX(1), // Start notes from column 1
+      headless_(false), lines_(0), cols_(0), stats_{} {}
+
+NcursesDrawer::NcursesDrawer(int lines, int cols)
+    : m_notePositionX(1), headless_(true), lines_(0), cols_(0), stats_{} {
+  resize(lines, cols);
+}
 
 NcursesDrawer::~NcursesDrawer() { end(); }
 
 void NcursesDrawer::init() {
+  if (headless_)
+    return;
   initscr();
   noecho();
   curs_set(FALSE);
   nodelay(stdscr, TRUE);
+  resize(LINES, COLS);
 }
 
 void NcursesDrawer::end() {
-  if (!isendwin())
+  if (!headless_ && !isendwin())
     endwin();
 }
 
+void NcursesDrawer::resize(int lines, int cols) {
+  lines_ = std::max(lines, 0);
+  cols_ = std::max(cols, 0);
+  back_.assign(static_cast<std::size_t>(lines_) * cols_, ' ');
+  front_ = back_; // a fresh screen is blank
+  dirtyLo_.assign(lines_, cols_);
+  dirtyHi_.assign(lines_, -1);
+}
+
+void NcursesDrawer::put(int y, int x, char ch) {
+  if (y < 0 || y >= lines_ || x < 0 || x >= cols_)
+    return;
+  char &cell = back_[static_cast<std::size_t>(y) * cols_ + x];
+  if (cell == ch)
+    return;
+  cell = ch;
+  dirtyLo_[y] = std::min(dirtyLo_[y], x);
+  dirtyHi_[y] = std::max(dirtyHi_[y], x);
+}
+
+void NcursesDrawer::text(int y, int x, const std::string &text) {
+  for (const char ch : text)
+    put(y, x++, ch);
+}
+
+void NcursesDrawer::clearToEol(int y, int x) {
+  for (; x < cols_; ++x)
+    put(y, x, ' ');
+}
+
+// Redraws the staff on a blank screen. Only cells that differ from the
+// previous frame reach the terminal, so wrapping to a new page costs the
+// notes it erases rather than a full repaint.
 void NcursesDrawer::drawStaff(int middleMIDINote) {
-  clear();
+  std::fill(back_.begin(), back_.end(), ' ');
+  std::fill(dirtyLo_.begin(), dirtyLo_.end(), 0);
+  std::fill(dirtyHi_.begin(), dirtyHi_.end(), cols_ - 1);
 
   const int staffStartCol = 0;
-  const int staffEndCol = COLS - 1;
-  const int middleY = LINES / 2;
+  const int staffEndCol = cols_ - 1;
+  const int middleY = lines_ / 2;
   for (int i = 0; i < 5; ++i) {
     const int lineY = middleY - 4 + (i * 2);
     for (int x = staffStartCol; x < staffEndCol; ++x)
-      mvaddch(lineY, x, CHAR_STAFF);
+      put(lineY, x, CHAR_STAFF);
   }
-  refresh();
 }
 
 void NcursesDrawer::drawLedgerLines(int verticalPosition, int notePositionX,
@@ -48,11 +92,11 @@ void NcursesDrawer::drawLedgerLines(int verticalPosition, int notePositionX,
   if (verticalPosition > bottomStaffLine) {
     for (int y = bottomStaffLine + 2; y <= verticalPosition; y += 2)
       for (int x = notePositionX - 2; x <= notePositionX + 2; ++x)
-        mvaddch(y, x, CHAR_STAFF);
+        put(y, x, CHAR_STAFF);
   } else if (verticalPosition < topStaffLine) {
     for (int y = topStaffLine - 2; y >= verticalPosition; y -= 2)
       for (int x = notePositionX - 2; x <= notePositionX + 2; ++x)
-        mvaddch(y, x, CHAR_STAFF);
+        put(y, x, CHAR_STAFF);
   }
 }
 
@@ -60,55 +104,106 @@ void NcursesDrawer::drawNote(const std::string &note, int octave,
                              const std::string &value, int fractionary,
                              int fractionaryStemCount, int middleMIDINote,
                              int midiNoteNumber, int counter) {
-  const int middleY = LINES / 2;
+  const int middleY = lines_ / 2;
   const int verticalPosition = middleY - (midiNoteNumber - middleMIDINote);
-  mvprintw(0, 0, "Playing: %s%d %s (#%d)        ", note.c_str(), octave,
-           value.c_str(), counter);
+  char playing[64];
+  std::snprintf(playing, sizeof playing, "Playing: %s%d %s (#%d)        ",
+                note.c_str(), octave, value.c_str(), counter);
+  text(0, 0, playing);
   drawLedgerLines(verticalPosition, m_notePositionX, middleY);
   if (fractionary > 1) {
     if (verticalPosition < middleY) {
       for (int y = verticalPosition + 4; y >= verticalPosition + 1; --y) {
-        mvaddch(y, m_notePositionX + 1, CHAR_NOTE_STEM_STD);
+        put(y, m_notePositionX + 1, CHAR_NOTE_STEM_STD);
         if (fractionaryStemCount-- > 0)
-          mvaddch(y, m_notePositionX, CHAR_NOTE_STEM_FRC);
+          put(y, m_notePositionX, CHAR_NOTE_STEM_FRC);
       }
     } else {
       for (int y = verticalPosition - 4; y <= verticalPosition - 1; ++y) {
-        mvaddch(y, m_notePositionX, CHAR_NOTE_STEM_STD);
+        put(y, m_notePositionX, CHAR_NOTE_STEM_STD);
         if (fractionaryStemCount-- > 0)
-          mvaddch(y, m_notePositionX + 1, CHAR_NOTE_STEM_FRC);
+          put(y, m_notePositionX + 1, CHAR_NOTE_STEM_FRC);
       }
     }
   }
   if (fractionary > 2)
-    mvaddch(verticalPosition, m_notePositionX - 1, CHAR_NOTE_HEAD_FULL);
+    put(verticalPosition, m_notePositionX - 1, CHAR_NOTE_HEAD_FULL);
   else
-    mvaddch(verticalPosition, m_notePositionX - 1, CHAR_NOTE_HEAD_BLANK);
+    put(verticalPosition, m_notePositionX - 1, CHAR_NOTE_HEAD_BLANK);
 
   if (note.find('#') != std::string::npos)
-    mvaddch(verticalPosition, m_notePositionX + 1, CHAR_NOTE_HEAD_S);
+    put(verticalPosition, m_notePositionX + 1, CHAR_NOTE_HEAD_S);
   else if (note.find('b') != std::string::npos)
-    mvaddch(verticalPosition, m_notePositionX + 1, CHAR_NOTE_HEAD_F);
+    put(verticalPosition, m_notePositionX + 1, CHAR_NOTE_HEAD_F);
 
   m_notePositionX += 5;
-  if (m_notePositionX >= COLS - 5) {
+  if (m_notePositionX >= cols_ - 5) {
     m_notePositionX = 1;
     drawStaff(middleMIDINote);
   }
+}
 
-  refresh();
+void NcursesDrawer::present() {
+  uint64_t cells = 0;
+  for (int y = 0; y < lines_; ++y) {
+    if (dirtyLo_[y] > dirtyHi_[y])
+      continue;
+    // Send each run of changed cells within the dirty span as one string.
+    const std::size_t rowStart = static_cast<std::size_t>(y) * cols_;
+    int x = dirtyLo_[y];
+    while (x <= dirtyHi_[y]) {
+      if (back_[rowStart + x] == front_[rowStart + x]) {
+        ++x;
+        continue;
+      }
+      const int runStart = x;
+      while (x <= dirtyHi_[y] && back_[rowStart + x] != front_[rowStart + x])
+        ++x;
+      const int run = x - runStart;
+      if (!headless_)
+        mvaddnstr(y, runStart, &back_[rowStart + runStart], run);
+      std::copy_n(&back_[rowStart + runStart], run,
+                  &front_[rowStart + runStart]);
+      cells += run;
+    }
+    dirtyLo_[y] = cols_;
+    dirtyHi_[y] = -1;
+  }
+  if (cells == 0)
+    return;
+  ++stats_.frames;
+  stats_.cellsWritten += cells;
+  if (!headless_)
+    refresh();
+}
+
+void NcursesDrawer::drawStatus(const std::string &status) {
+  const int width =
+      static_cast<int>(std::min<std::size_t>(status.size(), cols_));
+  text(lines_ - 2, 0, status.substr(0, width));
+  clearToEol(lines_ - 2, width);
 }
 
 void NcursesDrawer::displayIdle() {
-  mvprintw(0, 0, "Idle   ");
-  wclrtoeol(stdscr); // Clear the rest of the line
-  refresh();
+  text(0, 0, "Idle   ");
+  clearToEol(0, 7); // Clear the rest of the line
+  present();
 }
 
 void NcursesDrawer::waitForExit() {
-  mvprintw(LINES - 1, 0, "Press any key to exit...");
-  refresh();
+  text(lines_ - 1, 0, "Press any key to exit...");
+  present();
+  if (headless_)
+    return;
   nodelay(stdscr, FALSE);
   getch();
   nodelay(stdscr, TRUE);
 }
+
+int NcursesDrawer::readKey() { return headless_ ? ERR : getch(); }
+
+std::string NcursesDrawer::row(int y) const {
+  if (y < 0 || y >= lines_)
+    return {};
+  return std::string(&front_[static_cast<std::size_t>(y) * cols_], cols_);
+}
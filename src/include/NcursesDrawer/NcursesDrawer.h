@@ -1,24 +1,27 @@
 #pragma once
 
+#include <cstdint>
 #include <ncurses.h>
-#include <stdexcept>
 #include <string>
-#include <unordered_map>
+#include <vector>
 
-inline int getNoteOffset(const std::string &note) {
-  static const std::unordered_map<std::string, int> noteOffsets{
-      {"C", 0},  {"C#", 1}, {"Db", 1},  {"D", 2},   {"D#", 3}, {"Eb", 3},
-      {"E", 4},  {"F", 5},  {"F#", 6},  {"Gb", 6},  {"G", 7},  {"G#", 8},
-      {"Ab", 8}, {"A", 9},  {"A#", 10}, {"Bb", 10}, {"B", 11}};
-
-  if (!noteOffsets.contains(note))
-    throw std::invalid_argument("Invalid note name: " + note);
-
-  return noteOffsets.at(note);
-}
+// Draws into an off-screen cell buffer. Each row remembers the span of
+// columns written since the last frame, and present() compares only those
+// spans with what the terminal already shows, sending just the cells that
+// changed. A headless drawer keeps the buffer in memory and never touches
+// the terminal, so the cost of a frame can be measured without a TTY.
 class NcursesDrawer {
 public:
+  struct FrameStats {
+    uint64_t frames;       // present() calls that changed something
+    uint64_t cellsWritten; // cells sent to the screen over all frames
+  };
+
+  // Draws on the terminal, sized when init() is called.
   NcursesDrawer();
+  // Headless: `lines` x `cols` cells in memory; init(), end() and
+  // waitForExit() do not touch the terminal.
+  NcursesDrawer(int lines, int cols);
   ~NcursesDrawer();
   void init();
   void end();
@@ -26,12 +29,39 @@ public:
   void drawNote(const std::string &note, int octave, const std::string &value,
                 int fractionary, int fractionaryStemCount, int middleMIDINote,
                 int midiNoteNumber, int counter);
+  // Drawing only updates the cell buffer; present() sends what changed to
+  // the terminal.
+  void present();
+  // One line of text above the bottom row of the screen.
+  void drawStatus(const std::string &status);
   void displayIdle();
   void waitForExit();
+  // A key press, or ERR if there is none (always ERR when headless).
+  int readKey();
+
+  int lines() const { return lines_; }
+  int cols() const { return cols_; }
+  // Row `y` as it was last presented.
+  std::string row(int y) const;
+  FrameStats frameStats() const { return stats_; }
 
 private:
   void drawLedgerLines(int verticalPosition, int notePositionX, int middleY);
+  void resize(int lines, int cols);
+  void put(int y, int x, char ch);
+  void text(int y, int x, const std::string &text);
+  void clearToEol(int y, int x);
 
 private:
   int m_notePositionX;
+  bool headless_;
+  int lines_;
+  int cols_;
+  std::vector<char> back_;  // what has been drawn
+  std::vector<char> front_; // what the screen shows
+  // Per row, the columns written since the last frame: [dirtyLo_, dirtyHi_];
+  // empty when lo > hi.
+  std::vector<int> dirtyLo_;
+  std::vector<int> dirtyHi_;
+  FrameStats stats_;
 };
@@ -0,0 +1,97 @@
+#include "NcursesUiThread.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <utility>
+
+NcursesUiThread::NcursesUiThread(NcursesDrawer &drawer, int middleMIDINote,
+                                 unsigned maxFps)
+    : drawer_(drawer), running_(false), quit_(false), dropped_(0),
+      middleMIDINote_(middleMIDINote), maxFps_(std::max(maxFps, 1u)),
+      noteCounter_(0) {}
+
+NcursesUiThread::~NcursesUiThread() { stop(); }
+
+void NcursesUiThread::setStatus(std::function<std::string()> status) {
+  status_ = std::move(status);
+}
+
+void NcursesUiThread::start() {
+  if (thread_.joinable())
+    return;
+  drawer_.drawStaff(middleMIDINote_);
+  drawer_.present();
+  running_.store(true, std::memory_order_relaxed);
+  thread_ = std::thread(&NcursesUiThread::run, this);
+}
+
+void NcursesUiThread::stop() {
+  if (!thread_.joinable())
+    return;
+  running_.store(false, std::memory_order_relaxed);
+  thread_.join();
+}
+
+bool NcursesUiThread::post(const SongEvent &event) {
+  if (queue_.push(event))
+    return true;
+  dropped_.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+void NcursesUiThread::run() {
+  using Clock = std::chrono::steady_clock;
+  const auto frameInterval = std::chrono::microseconds(1000000 / maxFps_);
+  auto nextStatus = Clock::now();
+  auto nextFrame = Clock::now();
+  bool pending = false; // drawn but not yet presented
+  while (running_.load(std::memory_order_relaxed)) {
+    pending |= drainQueue();
+    const auto now = Clock::now();
+    if (status_ && now >= nextStatus) {
+      drawer_.drawStatus(status_());
+      nextStatus += std::chrono::milliseconds(STATUS_INTERVAL_MS);
+      pending = true;
+    }
+    if (pending && now >= nextFrame) {
+      drawer_.present();
+      pending = false;
+      nextFrame = now + frameInterval;
+    }
+    const int ch = drawer_.readKey();
+    if (ch == 'q' || ch == 'Q')
+      quit_.store(true, std::memory_order_relaxed);
+    std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL_MS));
+  }
+  if (drainQueue() || pending)
+    drawer_.present();
+}
+
+bool NcursesUiThread::drainQueue() {
+  bool drew = false;
+  SongEvent event;
+  while (queue_.pop(event)) {
+    if (event.kind == SongEvent::Kind::Note) {
+      render(event);
+      drew = true;
+    }
+  }
+  return drew;
+}
+
+void NcursesUiThread::render(const SongEvent &event) {
+  const int midiNoteNumber = event.midi;
+  const int middleY = drawer_.lines() / 2;
+  const int verticalPosition = middleY - (midiNoteNumber - middleMIDINote_);
+  if (verticalPosition < 2 || verticalPosition > (drawer_.lines() - 2)) {
+    middleMIDINote_ = midiNoteNumber;
+    drawer_.drawStaff(middleMIDINote_);
+  }
+  const int fractionary = event.fractionary;
+  const int fractionaryStemCount =
+      std::max(0, static_cast<int>(std::log2(fractionary) - 2));
+  drawer_.drawNote(event.name, event.octave, event.value, fractionary,
+                   fractionaryStemCount, middleMIDINote_, midiNoteNumber,
+                   ++noteCounter_);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "../Song/song.h"
+#include "../SpscRing/spscring.h"
+#include "NcursesDrawer.h"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <thread>
+
+// Runs all terminal work (drawing and keyboard polling) on its own thread so
+// playback never waits on a slow terminal. Playback posts the events it has
+// just started; the UI draws whatever has arrived and flushes at most
+// `maxFps` times a second, so at high tempos the notes that arrive within
+// one frame reach the terminal together.
+class NcursesUiThread {
+public:
+  static constexpr std::size_t QUEUE_EVENTS = 256;
+  static constexpr unsigned DEFAULT_FPS = 30;
+
+  explicit NcursesUiThread(NcursesDrawer &drawer, int middleMIDINote = 60,
+                           unsigned maxFps = DEFAULT_FPS);
+  ~NcursesUiThread();
+  NcursesUiThread(const NcursesUiThread &) = delete;
+  NcursesUiThread &operator=(const NcursesUiThread &) = delete;
+
+  // Shown on the status line and refreshed every STATUS_INTERVAL_MS. Set
+  // before start(); it is called on the UI thread.
+  void setStatus(std::function<std::string()> status);
+  void start();
+  // Draws what is still queued, then joins. The drawer is free to use from
+  // the calling thread afterwards.
+  void stop();
+
+  // Never blocks: if the queue is full the event is not drawn.
+  bool post(const SongEvent &event);
+  bool quitRequested() const {
+    return quit_.load(std::memory_order_relaxed);
+  }
+  std::size_t dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+private:
+  static constexpr int POLL_INTERVAL_MS = 5;
+  static constexpr int STATUS_INTERVAL_MS = 250;
+
+  void run();
+  bool drainQueue();
+  void render(const SongEvent &event);
+
+  NcursesDrawer &drawer_;
+  SpscRing<SongEvent, QUEUE_EVENTS> queue_;
+  std::atomic<bool> running_;
+  std::atomic<bool> quit_;
+  std::atomic<std::size_t> dropped_;
+  int middleMIDINote_;
+  unsigned maxFps_;
+  int noteCounter_;
+  std::function<std::string()> status_;
+  std::thread thread_;
+};
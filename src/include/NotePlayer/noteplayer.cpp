@@ -1,35 +1,38 @@
 #include "noteplayer.h"
-#include <cmath>
 #include <stdexcept>
 #include <unistd.h>
 
-NotePlayer::NotePlayer() {
-  durations_ = {{"w", 1},  {"h", 2},  {"q", 4},  {"e", 8},
-                {"s", 16}, {"t", 32}, {"sf", 64}};
-  notes_ = {{"C", 16.35},  {"C#", 17.32}, {"Db", 17.32}, {"D", 18.35},
-            {"D#", 19.45}, {"Eb", 19.45}, {"E", 20.6},   {"F", 21.83},
-            {"F#", 23.12}, {"Gb", 23.12}, {"G", 24.5},   {"G#", 25.96},
-            {"Ab", 25.96}, {"A", 27.5},   {"A#", 29.14}, {"Bb", 29.14},
-            {"B", 30.87}};
-}
+NotePlayer::NotePlayer(const pitch::Table &tuning) : tuning_(tuning) {}
 
 int NotePlayer::getFractionary(const std::string &valueName) const {
-  if (!durations_.contains(valueName))
+  const int fractionary = parseFractionary(valueName);
+  if (fractionary == 0)
     throw std::invalid_argument("Invalid duration value: " + valueName);
-  return durations_.at(valueName);
+  return fractionary;
 }
 
 int NotePlayer::getDuration(const std::string &valueName, const int bpm) const {
   return TIME_MS_QUAD / (bpm * getFractionary(valueName));
 }
 
+long NotePlayer::getDurationUs(const std::string &valueName,
+                               const int bpm) const {
+  return TIME_US_QUAD / (bpm * getFractionary(valueName));
+}
+
+float NotePlayer::getFrequency(const std::string &note, int octave) const {
+  const int offset = pitch::noteOffset(note);
+  const int midi = pitch::midiNumber(offset, octave);
+  if (offset < 0 || midi < 0 || midi > 127)
+    throw std::invalid_argument("Invalid note: " + note);
+  return getFrequency(midi);
+}
+
 void NotePlayer::play(const std::string &note, int octave,
                       const std::string &value, Speaker &speaker,
                       const int bpm) {
-  if (!notes_.contains(note))
-    throw std::invalid_argument("Invalid note: " + note);
-  float frequency = notes_.at(note) * std::pow(2, octave);
+  float frequency = getFrequency(note, octave);
   speaker.sendTone(static_cast<int>(frequency));
   usleep(1000 * getDuration(value, bpm));
   speaker.stop();
-}
\ No newline at end of file
+}
@@ -1,22 +1,45 @@
 #pragma once
 
+#include "../Pitch/pitch.h"
 #include "../Speaker/speaker.h"
-#include <map>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 class NotePlayer {
 public:
-  NotePlayer();
+  explicit NotePlayer(const pitch::Table &tuning = pitch::EQUAL_TEMPERAMENT);
   int getFractionary(const std::string &valueName) const;
   int getDuration(const std::string &valueName, const int bpm) const;
+  long getDurationUs(const std::string &valueName, const int bpm) const;
+  float getFrequency(const std::string &note, int octave) const;
+  float getFrequency(int midiNoteNumber) const {
+    return tuning_[static_cast<std::size_t>(midiNoteNumber)];
+  }
   void play(const std::string &note, int octave, const std::string &value,
             Speaker &speaker, const int bpm);
 
+  // Fractionary of a note value name ("w" = 1 ... "sf" = 64), 0 if invalid.
+  static constexpr int parseFractionary(std::string_view valueName) {
+    if (valueName.size() == 2)
+      return valueName == "sf" ? 64 : 0;
+    if (valueName.size() != 1)
+      return 0;
+    switch (valueName[0]) {
+    case 'w': return 1;
+    case 'h': return 2;
+    case 'q': return 4;
+    case 'e': return 8;
+    case 's': return 16;
+    case 't': return 32;
+    default: return 0;
+    }
+  }
+
+  static constexpr long TIME_US_QUAD = 240000000L;
+
 protected:
   // bpm to ms duration is generally calculated based on the quarter note duration
   // in order to generalize we calculate the quadruple of that and then adapt it to
   // the duration in accordance to their fractionary value
   static constexpr int TIME_MS_QUAD = 240000;
-  std::unordered_map<std::string, int> durations_;
-  std::unordered_map<std::string, float> notes_;
-};
\ No newline at end of file
+  pitch::Table tuning_;
+};
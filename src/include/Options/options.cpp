@@ -0,0 +1,70 @@
+#include "options.h"
+#include "parsenumber.h"
+
+#include <cstdlib>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+double parsePositive(std::string_view name, const std::string &value) {
+  char *end = nullptr;
+  const double result = std::strtod(value.c_str(), &end);
+  if (value.empty() || *end != '\0' || result <= 0.0)
+    throw std::invalid_argument("Invalid value for --" + std::string(name) +
+                                ": " + value);
+  return result;
+}
+} // namespace
+
+PlayerOptions parsePlayerOptions(int argc, char **argv) {
+  PlayerOptions options;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (!arg.starts_with("--")) {
+      options.positional.emplace_back(arg);
+      continue;
+    }
+    const std::size_t eq = arg.find('=');
+    const std::string_view name = arg.substr(2, eq - 2);
+    const std::string value =
+        eq == std::string_view::npos ? "" : std::string(arg.substr(eq + 1));
+    if (name == "tuning" && !value.empty()) {
+      options.tuning = value;
+    } else if (name == "a4") {
+      options.a4 = parsePositive(name, value);
+    } else if (name == "spin") {
+      options.spinUs = parseCount<unsigned>(name, value);
+    } else if (name == "fps") {
+      options.fps = parseCount<unsigned>(name, value);
+    } else if (name == "stats" && eq == std::string_view::npos) {
+      options.stats = true;
+    } else if (name == "dds" && eq == std::string_view::npos) {
+      options.dds = true;
+    } else if (name == "float" && eq == std::string_view::npos) {
+      options.floatOutput = true;
+    } else if (name == "timerfd" && eq == std::string_view::npos) {
+      options.timerfd = true;
+    } else if (name == "pwm") {
+      options.pwmRate = eq == std::string_view::npos
+                            ? 20000
+                            : parseCount<unsigned>(name, value);
+    } else if (name == "arpeggio") {
+      options.arpeggioHz =
+          eq == std::string_view::npos ? 60.0 : parsePositive(name, value);
+    } else if (name == "prerender" && eq == std::string_view::npos) {
+      options.prerender = true;
+    } else if (name == "threads") {
+      options.threads = parseCount<unsigned>(name, value);
+    } else if (name == "sink" && !value.empty()) {
+      options.sink = value;
+    } else if (name == "device" && !value.empty()) {
+      options.device = value;
+    } else if (name == "stats-csv" && !value.empty()) {
+      options.stats = true;
+      options.statsCsv = value;
+    } else {
+      throw std::invalid_argument("Unknown option: " + std::string(arg));
+    }
+  }
+  return options;
+}
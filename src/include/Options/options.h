@@ -0,0 +1,37 @@
+#pragma once
+
+#include "../Pitch/pitch.h"
+
+#include <string>
+#include <vector>
+
+// Command line shared by both players: positional arguments plus
+// "--name=value" options, which may appear anywhere.
+struct PlayerOptions {
+  std::vector<std::string> positional;
+  std::string tuning = "equal"; // --tuning=equal|just|<cents file>
+  double a4 = pitch::A4_REFERENCE; // --a4=<Hz>
+  unsigned spinUs = 0;             // --spin=<us> busy-wait before deadlines
+  bool stats = false;              // --stats: note timing report at exit
+  unsigned fps = 30;               // --fps=<n> screen updates per second
+  std::string statsCsv;            // --stats-csv=<file>: per-note timings
+  bool dds = false; // --dds: fixed-point int16 oscillator (soundcard only)
+  bool floatOutput = false; // --float: 32-bit float WAV (wavrender only)
+  bool prerender = false;   // --prerender: render the song on all cores first
+  unsigned threads = 0;     // --threads=<n> for --prerender, 0 = all cores
+  // --sink=portaudio|null|<file or FIFO>|- audio output (soundcard only)
+  std::string sink = "portaudio";
+  // --device=<path> file or FIFO to receive the pc speaker's tone events
+  // instead of the real device (speaker only)
+  std::string device;
+  bool timerfd = false; // --timerfd: timerfd-driven tone engine (speaker only)
+  // --pwm[=<Hz>] plays the selected waveform on the pc speaker by PWM at
+  // this rate (speaker only); 0 = off, a bare --pwm picks 20 kHz
+  unsigned pwmRate = 0;
+  // --arpeggio[=<Hz>] cycles through the notes of chords on the pc speaker
+  // at this rate (speaker only); 0 = off, a bare --arpeggio picks 60 Hz
+  double arpeggioHz = 0.0;
+};
+
+// Throws std::invalid_argument for unknown or malformed options.
+PlayerOptions parsePlayerOptions(int argc, char **argv);
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <charconv>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// Checked conversions for numeric command line values, shared by the players
+// and the tools. Every failure throws std::invalid_argument naming the
+// option, so it can be reported next to the usage text.
+
+// `value` in the range of T, so that the conversion cannot wrap.
+template <typename T>
+T checkedCast(std::string_view name, double value, const std::string &text) {
+  if (!(value <= static_cast<double>(std::numeric_limits<T>::max())))
+    throw std::invalid_argument("Value out of range for --" +
+                                std::string(name) + ": " + text);
+  return static_cast<T>(value);
+}
+
+// A whole number from 1 up to the largest T: no sign, fraction or exponent.
+template <typename T>
+T parseCount(std::string_view name, const std::string &text) {
+  unsigned long long value = 0;
+  const char *last = text.data() + text.size();
+  const auto [ptr, ec] = std::from_chars(text.data(), last, value);
+  if (ec == std::errc::result_out_of_range)
+    throw std::invalid_argument("Value out of range for --" +
+                                std::string(name) + ": " + text);
+  if (text.empty() || ec != std::errc() || ptr != last || value == 0)
+    throw std::invalid_argument("Invalid value for --" + std::string(name) +
+                                ": " + text);
+  return checkedCast<T>(name, static_cast<double>(value), text);
+}
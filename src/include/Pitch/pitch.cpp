@@ -0,0 +1,27 @@
+#include "pitch.h"
+
+#include <fstream>
+#include <stdexcept>
+
+namespace pitch {
+Table makeTuning(const std::string &name, double a4) {
+  if (a4 <= 0.0)
+    throw std::runtime_error("A4 reference must be positive");
+  if (name.empty() || name == "equal")
+    return equalTemperament(a4);
+  if (name == "just")
+    return justIntonation(a4);
+
+  std::ifstream input(name);
+  if (!input.is_open()) {
+    throw std::runtime_error("Failed to open tuning file: " + name);
+  }
+  CentsTable cents{};
+  for (double &value : cents) {
+    if (!(input >> value))
+      throw std::runtime_error("Tuning file must hold 12 cents values: " +
+                               name);
+  }
+  return fromCents(cents, a4);
+}
+} // namespace pitch
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Compile-time pitch tables. Every tuning is a 128-entry MIDI note number to
+// frequency table, so turning a note into a frequency at play time is a
+// single array load with no hashing and no pow().
+namespace pitch {
+using Table = std::array<float, 128>;
+using CentsTable = std::array<double, 12>; // cents of each pitch class above C
+
+inline constexpr double A4_REFERENCE = 440.0;
+inline constexpr int A4_MIDI = 69;
+
+namespace detail {
+// constexpr 2^x: integer part by repeated doubling, fractional part by the
+// exp() series, which converges quickly for |x| < 1.
+constexpr double exp2(double x) {
+  int whole = static_cast<int>(x);
+  if (x < whole)
+    --whole; // floor for negative x
+  const double y = (x - whole) * 0.69314718055994530942; // frac * ln(2)
+  double term = 1.0;
+  double sum = 1.0;
+  for (int n = 1; n < 30; ++n) {
+    term *= y / n;
+    sum += term;
+  }
+  for (; whole > 0; --whole)
+    sum *= 2.0;
+  for (; whole < 0; ++whole)
+    sum *= 0.5;
+  return sum;
+}
+} // namespace detail
+
+// Any 12-note tuning described by cents above C, repeated every octave and
+// scaled so that MIDI 69 (A4) sounds at `a4`.
+constexpr Table fromCents(const CentsTable &cents, double a4 = A4_REFERENCE) {
+  const double c4 = a4 / detail::exp2(cents[9] / 1200.0);
+  Table table{};
+  for (int midi = 0; midi < 128; ++midi) {
+    const int octaveFromC4 = midi / 12 - 5;
+    table[static_cast<std::size_t>(midi)] = static_cast<float>(
+        c4 * detail::exp2(octaveFromC4 + cents[midi % 12] / 1200.0));
+  }
+  return table;
+}
+
+inline constexpr CentsTable EQUAL_CENTS = {0,   100, 200, 300, 400,  500,
+                                           600, 700, 800, 900, 1000, 1100};
+
+// 5-limit just intonation relative to C:
+// 1, 16/15, 9/8, 6/5, 5/4, 4/3, 45/32, 3/2, 8/5, 5/3, 9/5, 15/8
+inline constexpr CentsTable JUST_CENTS = {
+    0.0,        111.731285, 203.910002, 315.641287, 386.313714, 498.044999,
+    590.223716, 701.955001, 813.686286, 884.358713, 1017.596288, 1088.268715};
+
+constexpr Table equalTemperament(double a4 = A4_REFERENCE) {
+  return fromCents(EQUAL_CENTS, a4);
+}
+
+constexpr Table justIntonation(double a4 = A4_REFERENCE) {
+  return fromCents(JUST_CENTS, a4);
+}
+
+inline constexpr Table EQUAL_TEMPERAMENT = equalTemperament();
+inline constexpr Table JUST_INTONATION = justIntonation();
+
+// Semitone offset above C of a note name ("C", "F#", "Bb"), or -1 if the
+// name is not one the score format accepts.
+constexpr int noteOffset(std::string_view name) {
+  // A B C D E F G
+  constexpr int LETTER_OFFSETS[7] = {9, 11, 0, 2, 4, 5, 7};
+  if (name.empty() || name.size() > 2)
+    return -1;
+  const unsigned letter = static_cast<unsigned char>(name[0]) - 'A';
+  if (letter >= 7)
+    return -1;
+  const int base = LETTER_OFFSETS[letter];
+  if (name.size() == 1)
+    return base;
+  // Only the accidentals that land on a black key are valid, matching the
+  // names the score format has always accepted (no "E#" or "Cb").
+  const bool sharp = name[1] == '#' && base != 4 && base != 11;
+  const bool flat = name[1] == 'b' && base != 0 && base != 5;
+  return sharp ? base + 1 : flat ? base - 1 : -1;
+}
+
+constexpr int midiNumber(int noteOffset, int octave) {
+  return (octave + 1) * 12 + noteOffset;
+}
+
+static_assert(noteOffset("C") == 0 && noteOffset("C#") == 1 &&
+              noteOffset("Db") == 1 && noteOffset("B") == 11 &&
+              noteOffset("Bb") == 10 && noteOffset("E#") == -1 &&
+              noteOffset("H") == -1 && noteOffset("") == -1);
+static_assert(EQUAL_TEMPERAMENT[A4_MIDI] == 440.0f);
+
+// Builds the table for a tuning chosen at startup: "equal", "just", or the
+// path of a file holding twelve cents values (C through B).
+// Throws std::runtime_error for unreadable or malformed files.
+Table makeTuning(const std::string &name, double a4 = A4_REFERENCE);
+} // namespace pitch
@@ -0,0 +1,126 @@
+#include "prerender.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace render {
+namespace {
+// Several chunks per thread, so a thread that draws a dense passage does not
+// leave the others idle at the end.
+constexpr uint64_t CHUNKS_PER_THREAD = 8;
+constexpr uint64_t MIN_CHUNK_FRAMES = Mixer::BLOCK * 64;
+
+// Where a chunk starts, and the mixer a serial render would have there.
+struct Chunk {
+  uint64_t start;
+  std::size_t firstNote;
+  Mixer mixer;
+};
+
+// Replays voice allocation alone, which costs nothing next to rendering.
+// Mixer::render retires a voice in the call that reaches its end, so the
+// pool before each noteOn is the pool after advanceTo(start).
+std::vector<Chunk> planChunks(const Timeline &timeline, const Mixer &mixer,
+                              uint64_t chunkFrames) {
+  std::vector<Chunk> chunks;
+  Mixer voices = mixer;
+  uint64_t frame = 0;
+  std::size_t note = 0;
+  for (uint64_t start = 0; start < timeline.frames; start += chunkFrames) {
+    for (; note < timeline.notes.size() && timeline.notes[note].start < start;
+         ++note) {
+      const Note &n = timeline.notes[note];
+      if (n.start > frame) {
+        voices.advanceTo(n.start);
+        frame = n.start;
+      }
+      voices.noteOn(n.start, n.end, n.increment, n.ddsIncrement);
+    }
+    if (start > frame) {
+      voices.advanceTo(start);
+      frame = start;
+    }
+    chunks.push_back({start, note, voices});
+  }
+  return chunks;
+}
+
+// The same walk as renderSong(), over the notes of one chunk.
+template <typename Sample>
+void renderChunk(const Timeline &timeline, Chunk &chunk, uint64_t end,
+                 Sample *out) {
+  uint64_t frame = chunk.start;
+  auto renderUntil = [&](uint64_t target) {
+    while (frame < target) {
+      const std::size_t n = static_cast<std::size_t>(
+          std::min<uint64_t>(target - frame, BLOCK_FRAMES));
+      chunk.mixer.render(out + frame, n, frame);
+      frame += n;
+    }
+  };
+  for (std::size_t i = chunk.firstNote;
+       i < timeline.notes.size() && timeline.notes[i].start < end; ++i) {
+    const Note &n = timeline.notes[i];
+    renderUntil(n.start);
+    chunk.mixer.noteOn(n.start, n.end, n.increment, n.ddsIncrement);
+  }
+  renderUntil(end);
+}
+} // namespace
+
+Timeline timelineOf(EventSource &song, double sampleRate) {
+  Timeline timeline;
+  uint64_t onsetUs = 0;
+  SongEvent event;
+  while (song.next(event)) {
+    onsetUs += event.delayUs;
+    const Note note = noteFor(event, onsetUs, sampleRate);
+    if (event.kind == SongEvent::Kind::Note)
+      timeline.notes.push_back(note);
+    timeline.frames = std::max(timeline.frames, note.end);
+  }
+  return timeline;
+}
+
+template <typename Sample>
+PcmBuffer<Sample> prerender(const Timeline &timeline, const Mixer &mixer,
+                            unsigned threads) {
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  uint64_t chunkFrames = timeline.frames / (threads * CHUNKS_PER_THREAD);
+  chunkFrames = std::max(MIN_CHUNK_FRAMES,
+                         (chunkFrames + Mixer::BLOCK - 1) / Mixer::BLOCK *
+                             Mixer::BLOCK);
+  std::vector<Chunk> chunks = planChunks(timeline, mixer, chunkFrames);
+
+  PcmBuffer<Sample> pcm;
+  pcm.frames = timeline.frames;
+  // Left uninitialised: every frame is written by exactly one chunk, and the
+  // pages are first touched by the thread that renders them.
+  pcm.samples = std::make_unique_for_overwrite<Sample[]>(pcm.frames);
+
+  std::atomic<std::size_t> nextChunk{0};
+  auto work = [&] {
+    for (std::size_t i = nextChunk.fetch_add(1); i < chunks.size();
+         i = nextChunk.fetch_add(1)) {
+      const uint64_t end = i + 1 < chunks.size() ? chunks[i + 1].start
+                                                 : timeline.frames;
+      renderChunk(timeline, chunks[i], end, pcm.samples.get());
+    }
+  };
+  std::vector<std::thread> workers;
+  const std::size_t helpers =
+      std::min<std::size_t>(threads, chunks.size()) - (chunks.empty() ? 0 : 1);
+  for (std::size_t i = 0; i < helpers; ++i)
+    workers.emplace_back(work);
+  work();
+  for (std::thread &worker : workers)
+    worker.join();
+  return pcm;
+}
+
+template PcmBuffer<float> prerender(const Timeline &, const Mixer &, unsigned);
+template PcmBuffer<int16_t> prerender(const Timeline &, const Mixer &,
+                                      unsigned);
+} // namespace render
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "../SoundPlayer/mixer.h"
+#include "../Song/eventsource.h"
+#include "songrenderer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Renders a whole song into memory ahead of playback, spread over several
+// threads. The song is cut into chunks that start on Mixer::BLOCK
+// boundaries; every chunk begins with the voices a serial render would have
+// at that frame, and Mixer::render derives each voice's phase from its start
+// frame, so the buffer matches renderSong() sample for sample.
+namespace render {
+// Every note of a song, sorted by start. `frames` runs to the end of the
+// last note or rest.
+struct Timeline {
+  std::vector<Note> notes;
+  uint64_t frames = 0;
+};
+
+Timeline timelineOf(EventSource &song, double sampleRate);
+
+template <typename Sample> struct PcmBuffer {
+  std::unique_ptr<Sample[]> samples;
+  uint64_t frames = 0;
+};
+
+// Sample must match the mixer: int16_t for DDS, float otherwise. `mixer` is
+// copied, never played through. With `threads` 0 every hardware thread is
+// used.
+template <typename Sample>
+PcmBuffer<Sample> prerender(const Timeline &timeline, const Mixer &mixer,
+                            unsigned threads = 0);
+
+extern template PcmBuffer<float> prerender(const Timeline &, const Mixer &,
+                                           unsigned);
+extern template PcmBuffer<int16_t> prerender(const Timeline &, const Mixer &,
+                                             unsigned);
+} // namespace render
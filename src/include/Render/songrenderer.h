@@ -0,0 +1,75 @@
+#pragma once
+
+#include "../SoundPlayer/dds.h"
+#include "../SoundPlayer/mixer.h"
+#include "../Song/eventsource.h"
+#include "../Song/song.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Offline counterpart of SoundPlayer::renderBuffer: walks a song and drives
+// the same Mixer, but against a frame counter instead of a sound card, so it
+// runs as fast as the CPU allows. Audio goes to `sink(const Sample *, frames)` in
+// blocks of up to BLOCK_FRAMES. The sink is a template parameter, so nothing
+// on the sample path is a virtual call.
+namespace render {
+constexpr std::size_t BLOCK_FRAMES = std::size_t{1} << 16;
+
+// One event of a song, in frames of the output stream.
+struct Note {
+  uint64_t start;
+  uint64_t end;
+  double increment;      // cycles per frame, for the float kernels
+  uint32_t ddsIncrement; // phase step, for the DDS oscillator
+};
+
+inline Note noteFor(const SongEvent &event, uint64_t onsetUs,
+                    double sampleRate) {
+  return {usToFrames(onsetUs, sampleRate),
+          usToFrames(onsetUs + event.durationUs, sampleRate),
+          event.frequency / sampleRate,
+          osc::dds::phaseIncrement(event.frequency, sampleRate)};
+}
+
+// Sample must match the mixer: int16_t for DDS, float otherwise. Returns the
+// number of frames rendered, which runs to the end of the last note.
+template <typename Sample, typename Sink>
+uint64_t renderSong(EventSource &song, Mixer &mixer, double sampleRate,
+                    Sink &&sink) {
+  std::vector<Sample> block(BLOCK_FRAMES);
+  std::size_t filled = 0;
+  uint64_t frame = 0;
+  auto renderUntil = [&](uint64_t target) {
+    while (frame < target) {
+      const std::size_t n = static_cast<std::size_t>(
+          std::min<uint64_t>(target - frame, BLOCK_FRAMES - filled));
+      mixer.render(block.data() + filled, n, frame);
+      filled += n;
+      frame += n;
+      if (filled == BLOCK_FRAMES) {
+        sink(block.data(), filled);
+        filled = 0;
+      }
+    }
+  };
+
+  uint64_t onsetUs = 0;
+  uint64_t endFrame = 0;
+  SongEvent event;
+  while (song.next(event)) {
+    onsetUs += event.delayUs;
+    const Note note = noteFor(event, onsetUs, sampleRate);
+    renderUntil(note.start);
+    if (event.kind == SongEvent::Kind::Note)
+      mixer.noteOn(note.start, note.end, note.increment, note.ddsIncrement);
+    endFrame = std::max(endFrame, note.end);
+  }
+  renderUntil(endFrame);
+  if (filled != 0)
+    sink(block.data(), filled);
+  return frame;
+}
+} // namespace render
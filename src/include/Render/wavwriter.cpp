@@ -0,0 +1,137 @@
+#include "wavwriter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+constexpr uint16_t WAVE_FORMAT_PCM = 1;
+constexpr uint16_t WAVE_FORMAT_IEEE_FLOAT = 3;
+
+template <typename T> void putLe(char *&dst, T value) {
+  std::memcpy(dst, &value, sizeof(value)); // the players target little-endian
+  dst += sizeof(value);
+}
+
+int16_t toInt16(float sample) {
+  return static_cast<int16_t>(
+      std::lrint(std::clamp(sample, -1.0f, 1.0f) * 32767.0f));
+}
+} // namespace
+
+WavWriter::WavWriter(const std::string &path, uint32_t sampleRate,
+                     Format format)
+    : path_(path), out_(path, std::ios::binary), sampleRate_(sampleRate),
+      format_(format), buffer_(BUFFER_BYTES), used_(0), frames_(0),
+      closed_(false) {
+  if (!out_.is_open()) {
+    throw std::runtime_error("Failed to create file: " + path);
+  }
+  writeHeader(); // placeholder sizes until close()
+}
+
+WavWriter::~WavWriter() {
+  try {
+    close();
+  } catch (...) {
+  }
+}
+
+void WavWriter::writeHeader() {
+  const bool isFloat = format_ == Format::Float32;
+  const uint16_t bytesPerSample = isFloat ? 4 : 2;
+  const uint64_t dataBytes = frames_ * bytesPerSample;
+  // Non-PCM formats carry a cbSize field and a fact chunk.
+  const uint32_t fmtBytes = isFloat ? 18 : 16;
+  const uint32_t factBytes = isFloat ? 12 : 0;
+  const uint64_t riffBytes = 4 + 8 + fmtBytes + factBytes + 8 + dataBytes;
+  if (riffBytes > std::numeric_limits<uint32_t>::max())
+    throw std::runtime_error("WAV files are limited to 4 GiB: " + path_);
+
+  char header[64];
+  char *p = header;
+  std::memcpy(p, "RIFF", 4);
+  p += 4;
+  putLe(p, static_cast<uint32_t>(riffBytes));
+  std::memcpy(p, "WAVEfmt ", 8);
+  p += 8;
+  putLe(p, fmtBytes);
+  putLe(p, isFloat ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM);
+  putLe(p, uint16_t{1}); // mono
+  putLe(p, sampleRate_);
+  putLe(p, sampleRate_ * bytesPerSample);
+  putLe(p, bytesPerSample);
+  putLe(p, static_cast<uint16_t>(bytesPerSample * 8));
+  if (isFloat) {
+    putLe(p, uint16_t{0});
+    std::memcpy(p, "fact", 4);
+    p += 4;
+    putLe(p, uint32_t{4});
+    putLe(p, static_cast<uint32_t>(frames_));
+  }
+  std::memcpy(p, "data", 4);
+  p += 4;
+  putLe(p, static_cast<uint32_t>(dataBytes));
+  out_.write(header, p - header);
+}
+
+template <typename Sample>
+void WavWriter::append(const Sample *samples, std::size_t frames) {
+  const std::size_t bytesPerSample = format_ == Format::Float32 ? 4 : 2;
+  while (frames > 0) {
+    if (used_ == buffer_.size())
+      flush();
+    const std::size_t n =
+        std::min(frames, (buffer_.size() - used_) / bytesPerSample);
+    char *dst = buffer_.data() + used_;
+    for (std::size_t i = 0; i < n; ++i) {
+      if (format_ == Format::Float32) {
+        float value;
+        if constexpr (std::is_same_v<Sample, float>)
+          value = samples[i];
+        else
+          value = samples[i] / 32768.0f;
+        putLe(dst, value);
+      } else {
+        int16_t value;
+        if constexpr (std::is_same_v<Sample, float>)
+          value = toInt16(samples[i]);
+        else
+          value = samples[i];
+        putLe(dst, value);
+      }
+    }
+    used_ += n * bytesPerSample;
+    frames_ += n;
+    samples += n;
+    frames -= n;
+  }
+}
+
+void WavWriter::write(const float *samples, std::size_t frames) {
+  append(samples, frames);
+}
+
+void WavWriter::write(const int16_t *samples, std::size_t frames) {
+  append(samples, frames);
+}
+
+void WavWriter::flush() {
+  out_.write(buffer_.data(), static_cast<std::streamsize>(used_));
+  used_ = 0;
+}
+
+void WavWriter::close() {
+  if (closed_)
+    return;
+  closed_ = true;
+  flush();
+  out_.seekp(0);
+  writeHeader();
+  out_.close();
+  if (out_.fail())
+    throw std::runtime_error("Failed to write file: " + path_);
+}
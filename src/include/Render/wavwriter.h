@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Writes a mono RIFF/WAVE file of 16-bit PCM or 32-bit float samples.
+// Samples are converted into a large staging buffer that goes to disk in
+// big sequential writes; the header's sizes are filled in by close().
+class WavWriter {
+public:
+  enum class Format { Int16, Float32 };
+  static constexpr std::size_t BUFFER_BYTES = std::size_t{1} << 20;
+
+  // Throws std::runtime_error if the file cannot be created.
+  WavWriter(const std::string &path, uint32_t sampleRate, Format format);
+  ~WavWriter();
+  WavWriter(const WavWriter &) = delete;
+  WavWriter &operator=(const WavWriter &) = delete;
+
+  void write(const float *samples, std::size_t frames);
+  void write(const int16_t *samples, std::size_t frames);
+  // Throws std::runtime_error if the file could not be completed.
+  void close();
+
+  uint64_t frames() const { return frames_; }
+
+private:
+  template <typename Sample>
+  void append(const Sample *samples, std::size_t frames);
+  void flush();
+  void writeHeader();
+
+  std::string path_;
+  std::ofstream out_;
+  uint32_t sampleRate_;
+  Format format_;
+  std::vector<char> buffer_;
+  std::size_t used_;
+  uint64_t frames_;
+  bool closed_;
+};
@@ -0,0 +1,57 @@
+#include "scheduler.h"
+
+#include <algorithm>
+#include <cerrno>
+
+Scheduler::Scheduler(uint32_t spinUs)
+    : spinNs_(static_cast<int64_t>(spinUs) * 1000), startNs_(0), events_(0),
+      lastLateNs_(0), maxLateNs_(0), totalLateNs_(0) {}
+
+void Scheduler::start() {
+  startNs_ = nowNs();
+  events_ = 0;
+  lastLateNs_ = maxLateNs_ = totalLateNs_ = 0;
+}
+
+int64_t Scheduler::waitUntil(uint64_t offsetUs) {
+  const int64_t deadline = deadlineNs(offsetUs);
+  const int64_t sleepUntil = deadline - spinNs_;
+  if (nowNs() < sleepUntil) {
+    timespec ts{};
+    ts.tv_sec = sleepUntil / 1000000000LL;
+    ts.tv_nsec = sleepUntil % 1000000000LL;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) ==
+           EINTR) {
+    }
+  }
+  int64_t now = nowNs();
+  while (now < deadline)
+    now = nowNs();
+
+  lastLateNs_ = now - deadline;
+  maxLateNs_ = std::max(maxLateNs_, lastLateNs_);
+  totalLateNs_ += lastLateNs_;
+  ++events_;
+  return lastLateNs_;
+}
+
+uint64_t Scheduler::elapsedUs() const {
+  return static_cast<uint64_t>(nowNs() - startNs_) / 1000;
+}
+
+Scheduler::Report Scheduler::report() const {
+  Report report{};
+  report.events = events_;
+  report.finalDriftNs = lastLateNs_;
+  report.maxLateNs = maxLateNs_;
+  report.meanLateNs =
+      events_ ? totalLateNs_ / static_cast<int64_t>(events_) : 0;
+  return report;
+}
+
+void Scheduler::printReport(std::ostream &out) const {
+  const Report r = report();
+  out << "Timing: " << r.events << " events, drift at end "
+      << r.finalDriftNs / 1e6 << " ms, mean late " << r.meanLateNs / 1e6
+      << " ms, max late " << r.maxLateNs / 1e6 << " ms\n";
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <ostream>
+
+// Absolute-deadline timing for playback. Every event is due at a fixed
+// offset from the moment the song started, so time lost to rendering or
+// device writes after one note is not carried over to the next and the tempo
+// cannot drag over a long song.
+class Scheduler {
+public:
+  struct Report {
+    uint64_t events;
+    // Lateness of the last deadline, which is the song's end: deadlines are
+    // absolute, so this is the total drift accumulated over the song.
+    int64_t finalDriftNs;
+    int64_t maxLateNs;    // worst wake-up lateness
+    int64_t meanLateNs;
+  };
+
+  // `spinUs` microseconds before each deadline the scheduler stops sleeping
+  // and busy-waits instead, trading a little CPU for tighter wake-ups.
+  explicit Scheduler(uint32_t spinUs = 0);
+
+  // Anchors offset zero to now.
+  void start();
+
+  // Blocks until `offsetUs` after start(); returns how late it woke, in ns.
+  int64_t waitUntil(uint64_t offsetUs);
+
+  // Elapsed time since start(), in microseconds.
+  uint64_t elapsedUs() const;
+
+  // Absolute CLOCK_MONOTONIC time of the deadline `offsetUs` after start().
+  int64_t deadlineNs(uint64_t offsetUs) const {
+    return startNs_ + static_cast<int64_t>(offsetUs) * 1000;
+  }
+  // CLOCK_MONOTONIC now, in ns. Inline, as audio callbacks time themselves
+  // with it.
+  static int64_t nowNs() {
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return toNs(ts);
+  }
+
+  Report report() const;
+  void printReport(std::ostream &out) const;
+
+private:
+  static int64_t toNs(const timespec &ts) {
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+  }
+
+  int64_t spinNs_;
+  int64_t startNs_;
+  uint64_t events_;
+  int64_t lastLateNs_;
+  int64_t maxLateNs_;
+  int64_t totalLateNs_;
+};
@@ -0,0 +1,166 @@
+#include "bzbformat.h"
+#include "../NotePlayer/noteplayer.h"
+
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+static_assert(std::endian::native == std::endian::little,
+              ".bzb files are read and written in little-endian order");
+
+namespace {
+constexpr const char *SHARP_NAMES[12] = {"C",  "C#", "D",  "D#", "E",  "F",
+                                         "F#", "G",  "G#", "A",  "A#", "B"};
+constexpr const char *FLAT_NAMES[12] = {"C",  "Db", "D",  "Eb", "E",  "F",
+                                        "Gb", "G",  "Ab", "A",  "Bb", "B"};
+constexpr const char *VALUE_NAMES[7] = {"w", "h", "q", "e", "s", "t", "sf"};
+
+template <typename T> void writeRaw(std::ofstream &out, const T &value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void copyName(char (&dst)[3], const char *src) {
+  std::memset(dst, 0, sizeof(dst));
+  std::strncpy(dst, src, sizeof(dst) - 1);
+}
+} // namespace
+
+void writeBzb(const std::vector<SongEvent> &events, const std::string &path) {
+  std::vector<BzbTempo> tempos;
+  std::vector<BzbEvent> packed;
+  packed.reserve(events.size());
+  uint32_t previousDurationUs = 0;
+  for (const SongEvent &event : events) {
+    // Version 1 has no onset field: every event starts when the previous
+    // one ends.
+    if (event.delayUs != previousDurationUs)
+      throw std::runtime_error(
+          "Chords and parallel tracks cannot be stored in a .bzb file");
+    previousDurationUs = event.durationUs;
+    if (tempos.empty() || tempos.back().bpm != event.bpm) {
+      tempos.push_back(
+          {static_cast<uint32_t>(packed.size()), event.bpm, 0});
+    }
+    BzbEvent out{};
+    out.value = static_cast<uint8_t>(std::countr_zero(
+        static_cast<unsigned>(event.fractionary)));
+    if (event.kind == SongEvent::Kind::Rest) {
+      out.midi = bzb::REST;
+    } else {
+      out.midi = event.midi;
+      if (event.name[1] == 'b')
+        out.value |= bzb::FLAT_SPELLING;
+    }
+    packed.push_back(out);
+  }
+
+  BzbHeader header{};
+  std::memcpy(header.magic, bzb::MAGIC, sizeof(header.magic));
+  header.version = bzb::VERSION;
+  header.headerSize = sizeof(BzbHeader);
+  header.tempoCount = static_cast<uint32_t>(tempos.size());
+  header.eventCount = static_cast<uint32_t>(packed.size());
+  header.tempoOffset = sizeof(BzbHeader);
+  header.eventOffset = static_cast<uint32_t>(
+      header.tempoOffset + tempos.size() * sizeof(BzbTempo));
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) {
+    throw std::runtime_error("Failed to create file: " + path);
+  }
+  writeRaw(out, header);
+  out.write(reinterpret_cast<const char *>(tempos.data()),
+            static_cast<std::streamsize>(tempos.size() * sizeof(BzbTempo)));
+  out.write(reinterpret_cast<const char *>(packed.data()),
+            static_cast<std::streamsize>(packed.size() * sizeof(BzbEvent)));
+  if (!out) {
+    throw std::runtime_error("Failed to write file: " + path);
+  }
+}
+
+bool BzbReader::isBzb(std::string_view data) {
+  return data.size() >= sizeof(bzb::MAGIC) &&
+         std::memcmp(data.data(), bzb::MAGIC, sizeof(bzb::MAGIC)) == 0;
+}
+
+BzbReader::BzbReader(MappedFile file, double sampleRate,
+                     const pitch::Table &tuning)
+    : file_(std::move(file)), sampleRate_(sampleRate), events_(nullptr),
+      eventCount_(0), pos_(0), tempoIndex_(0), previousDurationUs_(0),
+      tuning_(tuning) {
+  if (!isBzb(file_.view()))
+    throw std::runtime_error("Not a .bzb file");
+  if (file_.size() < sizeof(BzbHeader))
+    throw std::runtime_error("Truncated .bzb file");
+  BzbHeader header;
+  std::memcpy(&header, file_.data(), sizeof(header));
+  if (header.version != bzb::VERSION)
+    throw std::runtime_error("Unsupported .bzb version " +
+                             std::to_string(header.version));
+
+  const std::size_t tempoEnd =
+      std::size_t{header.tempoOffset} +
+      std::size_t{header.tempoCount} * sizeof(BzbTempo);
+  const std::size_t eventEnd =
+      std::size_t{header.eventOffset} +
+      std::size_t{header.eventCount} * sizeof(BzbEvent);
+  if (header.tempoOffset < header.headerSize || tempoEnd > file_.size() ||
+      eventEnd > file_.size())
+    throw std::runtime_error("Truncated .bzb file");
+
+  tempos_.resize(header.tempoCount);
+  std::memcpy(tempos_.data(), file_.data() + header.tempoOffset,
+              tempos_.size() * sizeof(BzbTempo));
+  for (std::size_t i = 0; i < tempos_.size(); ++i) {
+    if (tempos_[i].bpm == 0 ||
+        (i > 0 && tempos_[i].firstEvent <= tempos_[i - 1].firstEvent))
+      throw std::runtime_error("Corrupt .bzb tempo map");
+  }
+  if (header.eventCount > 0 &&
+      (tempos_.empty() || tempos_.front().firstEvent != 0))
+    throw std::runtime_error("Corrupt .bzb tempo map");
+
+  events_ = reinterpret_cast<const BzbEvent *>(file_.data() +
+                                               header.eventOffset);
+  eventCount_ = header.eventCount;
+}
+
+bool BzbReader::next(SongEvent &event) {
+  if (pos_ >= eventCount_)
+    return false;
+  while (tempoIndex_ + 1 < tempos_.size() &&
+         tempos_[tempoIndex_ + 1].firstEvent <= pos_)
+    ++tempoIndex_;
+
+  const BzbEvent packed = events_[pos_++];
+  const unsigned valueIndex = packed.value & bzb::VALUE_MASK;
+  if (valueIndex >= std::size(VALUE_NAMES) ||
+      (packed.midi != bzb::REST && packed.midi > 127))
+    throw std::runtime_error("Corrupt .bzb event at index " +
+                             std::to_string(pos_ - 1));
+
+  const unsigned bpm = tempos_[tempoIndex_].bpm;
+  event = SongEvent{};
+  event.fractionary = static_cast<uint8_t>(1u << valueIndex);
+  event.bpm = static_cast<uint16_t>(bpm);
+  event.durationUs = static_cast<uint32_t>(NotePlayer::TIME_US_QUAD /
+                                           (bpm * event.fractionary));
+  event.durationSamples = durationToSamples(event.durationUs, sampleRate_);
+  event.delayUs = previousDurationUs_;
+  previousDurationUs_ = event.durationUs;
+  copyName(event.value, VALUE_NAMES[valueIndex]);
+  if (packed.midi == bzb::REST) {
+    event.kind = SongEvent::Kind::Rest;
+  } else {
+    const char *const *names =
+        (packed.value & bzb::FLAT_SPELLING) ? FLAT_NAMES : SHARP_NAMES;
+    event.kind = SongEvent::Kind::Note;
+    event.midi = packed.midi;
+    event.octave = static_cast<int8_t>(packed.midi / 12 - 1);
+    event.frequency = tuning_[packed.midi];
+    copyName(event.name, names[packed.midi % 12]);
+  }
+  return true;
+}
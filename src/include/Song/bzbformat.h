@@ -0,0 +1,78 @@
+#pragma once
+
+#include "../Pitch/pitch.h"
+#include "eventsource.h"
+#include "mappedfile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// .bzb compiled song layout (little-endian):
+//
+//   BzbHeader                       24 bytes
+//   BzbTempo[tempoCount]            8 bytes each, sorted by firstEvent
+//   BzbEvent[eventCount]            2 bytes each
+//
+// Durations are not stored: they follow from each event's note value and the
+// tempo in effect, so a typical score shrinks to a third of its text size.
+namespace bzb {
+inline constexpr char MAGIC[4] = {'B', 'Z', 'B', '\0'};
+inline constexpr uint16_t VERSION = 1;
+inline constexpr uint8_t REST = 0xFF;        // BzbEvent::midi of a rest
+inline constexpr uint8_t VALUE_MASK = 0x07;  // log2 of the fractionary
+inline constexpr uint8_t FLAT_SPELLING = 0x80; // written as "Db" not "C#"
+} // namespace bzb
+
+struct BzbHeader {
+  char magic[4];
+  uint16_t version;
+  uint16_t headerSize;
+  uint32_t tempoCount;
+  uint32_t eventCount;
+  uint32_t tempoOffset;
+  uint32_t eventOffset;
+};
+static_assert(sizeof(BzbHeader) == 24);
+
+struct BzbTempo {
+  uint32_t firstEvent; // index of the first event played at this tempo
+  uint16_t bpm;
+  uint16_t reserved;
+};
+static_assert(sizeof(BzbTempo) == 8);
+
+struct BzbEvent {
+  uint8_t midi;  // MIDI note number or bzb::REST
+  uint8_t value; // log2(fractionary) | bzb::FLAT_SPELLING
+};
+static_assert(sizeof(BzbEvent) == 2);
+
+// Throws std::runtime_error for scores with overlapping notes, which the
+// format cannot express.
+void writeBzb(const std::vector<SongEvent> &events, const std::string &path);
+
+// Plays a .bzb file straight out of its memory mapping: each event is
+// expanded into a SongEvent only when it is reached.
+class BzbReader : public EventSource {
+public:
+  BzbReader(MappedFile file, double sampleRate,
+            const pitch::Table &tuning = pitch::EQUAL_TEMPERAMENT);
+  static bool isBzb(std::string_view data);
+
+  bool next(SongEvent &event) override;
+  std::size_t size() const { return eventCount_; }
+
+private:
+  MappedFile file_;
+  double sampleRate_;
+  const BzbEvent *events_;
+  std::size_t eventCount_;
+  std::vector<BzbTempo> tempos_;
+  std::size_t pos_;
+  std::size_t tempoIndex_;
+  uint32_t previousDurationUs_;
+  pitch::Table tuning_;
+};
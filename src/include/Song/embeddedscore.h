@@ -0,0 +1,131 @@
+#pragma once
+
+#include "../Pitch/pitch.h"
+#include "eventsource.h"
+#include "scoretokenizer.h"
+#include "song.h"
+#include "songparser.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Compiles a text score while the program itself is being compiled, for
+// players with their song built in: startup then does no file I/O and no
+// parsing, the events are just a constant array. SongParser itself does the
+// parsing, and the tracks are merged as SongCompiler does, so the events come
+// out identical.
+//
+//   constexpr std::string_view SCORE = "bpm 120 C 4 q & E 4 q G 4 h";
+//   constexpr auto SONG = embedded::compile<embedded::eventCount(SCORE)>(SCORE);
+//
+// A malformed score does not compile. The compiler's "in 'constexpr'
+// expansion of" notes end at embedded::detail::CompileTimeError::fail(),
+// whose arguments hold the score line and column and the message.
+namespace embedded {
+namespace detail {
+// Deliberately not constexpr: reaching it during constant evaluation is
+// what turns a score error into a compile error.
+inline void scoreHasSyntaxError() {}
+
+// SongParser's error policy while the score is being compiled.
+struct CompileTimeError {
+  static constexpr void fail(std::size_t line, std::size_t column,
+                             const char *message, std::string_view) {
+    if (message != nullptr || line != 0 || column != 0)
+      scoreHasSyntaxError();
+  }
+};
+
+using Parser = BasicSongParser<CompileTimeError>;
+} // namespace detail
+
+// Number of events in `score`; the size to pass to compile().
+consteval std::size_t eventCount(std::string_view score) {
+  detail::Parser parser(SongCompiler::DEFAULT_SAMPLE_RATE);
+  ScoreTokenizer tokenizer(score);
+  ScoreTokenizer::Token token;
+  SongEvent event{};
+  std::size_t count = 0;
+  while (tokenizer.next(token))
+    count += parser.feed(token, event) ? 1 : 0;
+  parser.finish(tokenizer.line(), tokenizer.column());
+  return count;
+}
+
+template <std::size_t N>
+consteval std::array<SongEvent, N>
+compile(std::string_view score,
+        double sampleRate = SongCompiler::DEFAULT_SAMPLE_RATE) {
+  detail::Parser parser(sampleRate);
+  ScoreTokenizer tokenizer(score);
+  ScoreTokenizer::Token token;
+  std::array<SongEvent, N> events{};
+  // Onset of each event within its own track, to merge parallel tracks.
+  std::array<uint64_t, N> onsets{};
+  std::size_t count = 0;
+  std::size_t track = 0;
+  uint64_t trackTimeUs = 0;
+  SongEvent event{};
+  while (tokenizer.next(token)) {
+    if (!parser.feed(token, event))
+      continue;
+    if (parser.track() != track) {
+      track = parser.track();
+      trackTimeUs = 0;
+    }
+    trackTimeUs += event.delayUs;
+    events[count] = event;
+    onsets[count++] = trackTimeUs;
+  }
+  parser.finish(tokenizer.line(), tokenizer.column());
+  if (track == 0)
+    return events;
+
+  // Stable insertion sort by onset, so ties keep score order as in
+  // SongCompiler; then delays become relative to the merged sequence.
+  for (std::size_t i = 1; i < N; ++i) {
+    for (std::size_t j = i; j > 0 && onsets[j - 1] > onsets[j]; --j) {
+      const SongEvent swapped = events[j];
+      events[j] = events[j - 1];
+      events[j - 1] = swapped;
+      const uint64_t onset = onsets[j];
+      onsets[j] = onsets[j - 1];
+      onsets[j - 1] = onset;
+    }
+  }
+  uint64_t previous = 0;
+  for (std::size_t i = 0; i < N; ++i) {
+    events[i].delayUs = static_cast<uint32_t>(onsets[i] - previous);
+    previous = onsets[i];
+  }
+  return events;
+}
+
+// Plays a compiled array in place. Frequencies were resolved in equal
+// temperament at A4 = 440 Hz; any other tuning is looked up per event by
+// MIDI note number.
+class ArrayEventSource : public EventSource {
+public:
+  template <std::size_t N>
+  explicit ArrayEventSource(
+      const std::array<SongEvent, N> &events,
+      const pitch::Table &tuning = pitch::EQUAL_TEMPERAMENT)
+      : pos_(events.data()), end_(events.data() + N), tuning_(tuning) {}
+
+  bool next(SongEvent &event) override {
+    if (pos_ == end_)
+      return false;
+    event = *pos_++;
+    if (event.kind == SongEvent::Kind::Note)
+      event.frequency = tuning_[event.midi];
+    return true;
+  }
+
+private:
+  const SongEvent *pos_;
+  const SongEvent *end_;
+  pitch::Table tuning_;
+};
+} // namespace embedded
@@ -0,0 +1,82 @@
+#include "eventsource.h"
+#include "bzbformat.h"
+#include "mappedfile.h"
+#include "midifile.h"
+#include "streamsource.h"
+
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+namespace {
+// Hands the score on stdin to the caller and points stdin back at the
+// terminal, so ncurses keyboard input keeps working while a pipe feeds us.
+int takeStdin() {
+  const int fd = dup(STDIN_FILENO);
+  if (fd == -1) {
+    throw std::runtime_error("Failed to duplicate stdin");
+  }
+  if (!isatty(STDIN_FILENO)) {
+    const int tty = open("/dev/tty", O_RDONLY);
+    if (tty != -1) {
+      dup2(tty, STDIN_FILENO);
+      close(tty);
+    }
+  }
+  return fd;
+}
+} // namespace
+
+VectorEventSource::VectorEventSource(std::vector<SongEvent> events)
+    : events_(std::move(events)), pos_(0) {}
+
+bool VectorEventSource::next(SongEvent &event) {
+  if (pos_ >= events_.size())
+    return false;
+  event = events_[pos_++];
+  return true;
+}
+
+bool isStreamInput(const std::string &path) {
+  struct stat st {};
+  return path == "-" || (stat(path.c_str(), &st) == 0 && !S_ISREG(st.st_mode));
+}
+
+std::unique_ptr<EventSource> openSong(const std::string &path,
+                                      double sampleRate,
+                                      const pitch::Table &tuning,
+                                      bool stream) {
+  const SongCompiler compiler(sampleRate, tuning);
+  if (path == "-") {
+    if (!stream)
+      return std::make_unique<VectorEventSource>(compiler.compile(std::cin));
+    return std::make_unique<StreamEventSource>(takeStdin(), sampleRate,
+                                               tuning);
+  }
+  if (isStreamInput(path)) {
+    if (!stream) {
+      std::ifstream input(path);
+      if (!input.is_open()) {
+        throw std::runtime_error("Failed to open file: " + path);
+      }
+      return std::make_unique<VectorEventSource>(compiler.compile(input));
+    }
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+      throw std::runtime_error("Failed to open file: " + path);
+    }
+    return std::make_unique<StreamEventSource>(fd, sampleRate, tuning);
+  }
+
+  MappedFile file(path);
+  if (BzbReader::isBzb(file.view()))
+    return std::make_unique<BzbReader>(std::move(file), sampleRate,
+                                       tuning);
+  if (MidiReader::isMidi(file.view()))
+    return std::make_unique<MidiReader>(std::move(file), sampleRate, tuning);
+  return std::make_unique<VectorEventSource>(compiler.compile(file.view()));
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "../Pitch/pitch.h"
+#include "song.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Sequential access to a song's events, regardless of where they come from.
+// Playback only ever walks forward, so this is all the players need.
+class EventSource {
+public:
+  virtual ~EventSource() = default;
+  virtual bool next(SongEvent &event) = 0;
+};
+
+class VectorEventSource : public EventSource {
+public:
+  explicit VectorEventSource(std::vector<SongEvent> events);
+  bool next(SongEvent &event) override;
+
+private:
+  std::vector<SongEvent> events_;
+  std::size_t pos_;
+};
+
+// Opens a score in the text or .bzb format, or a Standard MIDI File, telling
+// them apart by the file's magic bytes. Text scores are compiled in full
+// before returning. "-" and non-regular files such as FIFOs are streamed
+// instead, unless `stream` is false: offline renderers have no playback
+// clock for underrun rests to fill, so they read such inputs to the end and
+// compile them whole.
+std::unique_ptr<EventSource>
+openSong(const std::string &path, double sampleRate,
+         const pitch::Table &tuning = pitch::EQUAL_TEMPERAMENT,
+         bool stream = true);
+
+// True for "-" and the non-regular files that openSong() streams, whose end
+// may never come.
+bool isStreamInput(const std::string &path);
@@ -0,0 +1,254 @@
+#include "midifile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace {
+constexpr char MTHD[4] = {'M', 'T', 'h', 'd'};
+constexpr char MTRK[4] = {'M', 'T', 'r', 'k'};
+constexpr uint32_t DEFAULT_US_PER_QUARTER = 500000; // 120 bpm
+constexpr unsigned PERCUSSION_CHANNEL = 9;
+constexpr const char *NAMES[12] = {"C",  "C#", "D",  "D#", "E",  "F",
+                                   "F#", "G",  "G#", "A",  "A#", "B"};
+constexpr const char *VALUE_NAMES[7] = {"w", "h", "q", "e", "s", "t", "sf"};
+
+[[noreturn]] void malformed(const std::string &what) {
+  throw std::runtime_error("Malformed MIDI file: " + what);
+}
+
+uint32_t readBig(const uint8_t *p, int bytes) {
+  uint32_t value = 0;
+  for (int i = 0; i < bytes; ++i)
+    value = (value << 8) | p[i];
+  return value;
+}
+
+// Variable-length quantity: 7 bits per byte, high bit set on all but the
+// last, at most four bytes.
+uint32_t readVlq(const uint8_t *&pos, const uint8_t *end) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; ++i) {
+    if (pos == end)
+      malformed("truncated track");
+    const uint8_t byte = *pos++;
+    value = (value << 7) | (byte & 0x7F);
+    if (!(byte & 0x80))
+      return value;
+  }
+  malformed("variable-length number longer than four bytes");
+}
+
+void copyName(char (&dst)[3], const char *src) {
+  std::memset(dst, 0, sizeof(dst));
+  std::strncpy(dst, src, sizeof(dst) - 1);
+}
+} // namespace
+
+bool MidiReader::isMidi(std::string_view data) {
+  return data.size() >= sizeof(MTHD) &&
+         std::memcmp(data.data(), MTHD, sizeof(MTHD)) == 0;
+}
+
+MidiReader::MidiReader(MappedFile file, double sampleRate,
+                       const pitch::Table &tuning)
+    : file_(std::move(file)), sampleRate_(sampleRate), tuning_(tuning),
+      division_(0), usPerQuarter_(DEFAULT_US_PER_QUARTER), smpte_(false),
+      tempoTick_(0), tempoUs_(0), lastUs_(0), firstId_(0),
+      open_(16 * 128, NOT_OPEN), previousOnsetUs_(0) {
+  if (!isMidi(file_.view()))
+    throw std::runtime_error("Not a MIDI file");
+  const auto *data = reinterpret_cast<const uint8_t *>(file_.data());
+  const std::size_t size = file_.size();
+  if (size < 14)
+    malformed("truncated header");
+  const uint32_t headerLength = readBig(data + 4, 4);
+  if (headerLength < 6 || headerLength > size - 8)
+    malformed("bad header length");
+  const unsigned format = readBig(data + 8, 2);
+  const unsigned trackCount = readBig(data + 10, 2);
+  const unsigned division = readBig(data + 12, 2);
+  if (format > 1)
+    throw std::runtime_error("MIDI file type " + std::to_string(format) +
+                             " is not supported");
+  if (division & 0x8000) {
+    // SMPTE: -frames per second in the high byte, ticks per frame below;
+    // the tempo map does not apply.
+    smpte_ = true;
+    const unsigned fps = 256 - (division >> 8);
+    division_ = fps * (division & 0xFF);
+    usPerQuarter_ = 1000000;
+  } else {
+    division_ = division;
+  }
+  if (division_ == 0)
+    malformed("zero time division");
+
+  // Track chunks follow the header; chunks of other types are skipped.
+  tracks_.reserve(trackCount);
+  std::size_t offset = 8 + headerLength;
+  while (offset + 8 <= size && tracks_.size() < trackCount) {
+    const uint32_t length = readBig(data + offset + 4, 4);
+    if (length > size - offset - 8)
+      malformed("truncated track chunk");
+    if (std::memcmp(data + offset, MTRK, sizeof(MTRK)) == 0 && length > 0)
+      tracks_.push_back({data + offset + 8, data + offset + 8 + length, 0, 0});
+    offset += 8 + std::size_t{length};
+  }
+  for (Track &track : tracks_) {
+    readDelta(track);
+    heap_.push(&track);
+  }
+}
+
+void MidiReader::readDelta(Track &track) {
+  track.tick += readVlq(track.pos, track.end);
+}
+
+uint64_t MidiReader::toUs(uint64_t tick) const {
+  return tempoUs_ + (tick - tempoTick_) * usPerQuarter_ / division_;
+}
+
+bool MidiReader::next(SongEvent &event) {
+  for (;;) {
+    // Zero-length notes are dropped rather than played.
+    while (!pending_.empty() && pending_.front().closed &&
+           pending_.front().endUs == pending_.front().startUs) {
+      pending_.pop_front();
+      ++firstId_;
+    }
+    if (!pending_.empty() && pending_.front().closed) {
+      fill(event, pending_.front());
+      pending_.pop_front();
+      ++firstId_;
+      return true;
+    }
+    if (!step()) {
+      if (pending_.empty())
+        return false;
+      // Notes still held when every track has ended stop at the last event.
+      for (uint64_t &id : open_) {
+        if (id != NOT_OPEN) {
+          Pending &note = pending_[id - firstId_];
+          note.endUs = lastUs_;
+          note.closed = true;
+          id = NOT_OPEN;
+        }
+      }
+    }
+  }
+}
+
+// Decodes the earliest event over all tracks.
+bool MidiReader::step() {
+  if (heap_.empty())
+    return false;
+  Track &track = *heap_.top();
+  heap_.pop();
+  const uint64_t us = toUs(track.tick);
+  lastUs_ = std::max(lastUs_, us);
+
+  if (track.pos == track.end)
+    malformed("truncated track");
+  uint8_t status = *track.pos;
+  if (status & 0x80)
+    ++track.pos;
+  else if (track.status == 0)
+    malformed("data byte without a status byte");
+  else
+    status = track.status; // running status: the byte is data
+
+  bool ended = false;
+  if (status == 0xFF) {
+    if (track.end - track.pos < 1)
+      malformed("truncated meta event");
+    const uint8_t type = *track.pos++;
+    const uint32_t length = readVlq(track.pos, track.end);
+    if (length > static_cast<std::size_t>(track.end - track.pos))
+      malformed("truncated meta event");
+    if (type == 0x51 && length == 3 && !smpte_) {
+      tempoUs_ = us;
+      tempoTick_ = track.tick;
+      usPerQuarter_ = readBig(track.pos, 3);
+      if (usPerQuarter_ == 0)
+        malformed("zero tempo");
+    } else if (type == 0x2F) {
+      ended = true;
+    }
+    track.pos += length;
+  } else if (status == 0xF0 || status == 0xF7) {
+    const uint32_t length = readVlq(track.pos, track.end);
+    if (length > static_cast<std::size_t>(track.end - track.pos))
+      malformed("truncated system exclusive event");
+    track.pos += length;
+  } else if (status >= 0x80 && status < 0xF0) {
+    track.status = status;
+    const unsigned kind = status >> 4;
+    const unsigned channel = status & 0x0F;
+    const std::size_t dataBytes = kind == 0xC || kind == 0xD ? 1 : 2;
+    if (static_cast<std::size_t>(track.end - track.pos) < dataBytes)
+      malformed("truncated channel event");
+    const uint8_t key = track.pos[0] & 0x7F;
+    const uint8_t velocity = dataBytes > 1 ? track.pos[1] & 0x7F : 0;
+    track.pos += dataBytes;
+    if (channel != PERCUSSION_CHANNEL) {
+      if (kind == 0x9 && velocity > 0)
+        noteOn(channel, key, us);
+      else if (kind == 0x8 || kind == 0x9)
+        noteOff(channel, key, us);
+    }
+  } else {
+    malformed("unexpected status byte");
+  }
+
+  if (!ended && track.pos < track.end) {
+    readDelta(track);
+    heap_.push(&track);
+  }
+  return true;
+}
+
+void MidiReader::noteOn(unsigned channel, unsigned key, uint64_t us) {
+  // A repeated note-on without a note-off in between restarts the note.
+  noteOff(channel, key, us);
+  open_[channel * 128 + key] = firstId_ + pending_.size();
+  pending_.push_back(
+      {us, us, usPerQuarter_, static_cast<uint8_t>(key), false});
+}
+
+void MidiReader::noteOff(unsigned channel, unsigned key, uint64_t us) {
+  uint64_t &id = open_[channel * 128 + key];
+  if (id == NOT_OPEN)
+    return;
+  Pending &note = pending_[id - firstId_];
+  note.endUs = us;
+  note.closed = true;
+  id = NOT_OPEN;
+}
+
+void MidiReader::fill(SongEvent &event, const Pending &note) {
+  event = SongEvent{};
+  event.kind = SongEvent::Kind::Note;
+  event.midi = note.midi;
+  event.octave = static_cast<int8_t>(note.midi / 12 - 1);
+  event.frequency = tuning_[note.midi];
+  copyName(event.name, NAMES[note.midi % 12]);
+  event.durationUs = static_cast<uint32_t>(note.endUs - note.startUs);
+  event.durationSamples = durationToSamples(event.durationUs, sampleRate_);
+  event.delayUs = static_cast<uint32_t>(note.startUs - previousOnsetUs_);
+  previousOnsetUs_ = note.startUs;
+  event.bpm = static_cast<uint16_t>(
+      std::lround(60000000.0 / note.usPerQuarter));
+
+  // Whole note = 4 quarters; pick the closest power-of-two division.
+  const double quarters =
+      static_cast<double>(event.durationUs) / note.usPerQuarter;
+  const int exponent =
+      static_cast<int>(std::lround(std::log2(4.0 / quarters)));
+  const int valueIndex = std::clamp(exponent, 0, 6);
+  event.fractionary = static_cast<uint8_t>(1u << valueIndex);
+  copyName(event.value, VALUE_NAMES[valueIndex]);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "../Pitch/pitch.h"
+#include "eventsource.h"
+#include "mappedfile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <queue>
+#include <string_view>
+#include <vector>
+
+// Plays a Standard MIDI File (type 0 or 1) straight out of its memory
+// mapping. Every track keeps a cursor into its chunk, and a min-heap keyed
+// on each cursor's next tick merges the tracks in time order, so events are
+// decoded only as playback reaches them. Tick times go through the tempo
+// map as it is met.
+//
+// A note becomes a SongEvent once its note-off has been read; later notes
+// wait behind it so events still come out in onset order. Channel 10 holds
+// unpitched percussion and is skipped. Note values are only for display:
+// each duration is rounded to the nearest power-of-two note value.
+class MidiReader : public EventSource {
+public:
+  // Throws std::runtime_error for malformed files and for type 2 files.
+  MidiReader(MappedFile file, double sampleRate,
+             const pitch::Table &tuning = pitch::EQUAL_TEMPERAMENT);
+  static bool isMidi(std::string_view data);
+
+  bool next(SongEvent &event) override;
+  std::size_t tracks() const { return tracks_.size(); }
+
+private:
+  struct Track {
+    const uint8_t *pos;
+    const uint8_t *end;
+    uint64_t tick; // absolute tick of the event at `pos`
+    uint8_t status; // running status
+  };
+  struct Later {
+    bool operator()(const Track *a, const Track *b) const {
+      return a->tick != b->tick ? a->tick > b->tick : a > b;
+    }
+  };
+  struct Pending {
+    uint64_t startUs;
+    uint64_t endUs;
+    uint32_t usPerQuarter; // tempo at the onset, for the note value
+    uint8_t midi;
+    bool closed;
+  };
+  static constexpr uint64_t NOT_OPEN = UINT64_MAX;
+
+  bool step();
+  void readDelta(Track &track);
+  void noteOn(unsigned channel, unsigned key, uint64_t us);
+  void noteOff(unsigned channel, unsigned key, uint64_t us);
+  uint64_t toUs(uint64_t tick) const;
+  void fill(SongEvent &event, const Pending &note);
+
+  MappedFile file_;
+  double sampleRate_;
+  pitch::Table tuning_;
+  std::vector<Track> tracks_;
+  std::priority_queue<Track *, std::vector<Track *>, Later> heap_;
+  // Tempo map state: ticks convert to microseconds from the last change.
+  uint32_t division_;     // ticks per quarter note (or per second, SMPTE)
+  uint32_t usPerQuarter_; // current tempo
+  bool smpte_;
+  uint64_t tempoTick_;
+  uint64_t tempoUs_;
+  uint64_t lastUs_;
+  // Notes in onset order; open_ maps channel * 128 + key to the id of its
+  // sounding note, where a note's id is firstId_ plus its index.
+  std::deque<Pending> pending_;
+  uint64_t firstId_;
+  std::vector<uint64_t> open_;
+  uint64_t previousOnsetUs_;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Splits score text on whitespace without copying: every token is a view into
+// the caller's buffer (usually a MappedFile), so tokenizing never allocates.
+// Line and column are tracked for error reporting. Everything is constexpr so
+// that scores embedded in the binary can be tokenized at compile time.
+class ScoreTokenizer {
+public:
+  struct Token {
+    std::string_view text;
+    std::size_t line = 0;
+    std::size_t column = 0;
+  };
+
+  // `firstLine` lets a caller feeding the text in whole-line chunks keep the
+  // line numbers relative to the full input.
+  constexpr explicit ScoreTokenizer(std::string_view text, std::size_t firstLine = 1)
+      : cur_(text.data()), end_(text.data() + text.size()),
+        lineStart_(text.data()), line_(firstLine) {}
+
+  constexpr bool next(Token &token) {
+    while (cur_ != end_ && isSpace(*cur_)) {
+      if (*cur_ == '\n') {
+        ++line_;
+        lineStart_ = cur_ + 1;
+      }
+      ++cur_;
+    }
+    if (cur_ == end_)
+      return false;
+    const char *start = cur_;
+    while (cur_ != end_ && !isSpace(*cur_))
+      ++cur_;
+    token.text = std::string_view(start, static_cast<std::size_t>(cur_ - start));
+    token.line = line_;
+    token.column = static_cast<std::size_t>(start - lineStart_) + 1;
+    return true;
+  }
+
+  // Position just past the last consumed character, used to report
+  // unexpected end of input.
+  constexpr std::size_t line() const { return line_; }
+  constexpr std::size_t column() const {
+    return static_cast<std::size_t>(cur_ - lineStart_) + 1;
+  }
+
+private:
+  static constexpr bool isSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' ||
+           c == '\f';
+  }
+
+  const char *cur_;
+  const char *end_;
+  const char *lineStart_;
+  std::size_t line_;
+};
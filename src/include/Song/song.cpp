@@ -0,0 +1,88 @@
+#include "song.h"
+#include "mappedfile.h"
+#include "scoretokenizer.h"
+#include "songparser.h"
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+
+namespace {
+// Interleaves the tracks by onset. `onsets` holds each event's start within
+// its own track; ties keep score order, so earlier tracks sound first.
+void mergeTracks(std::vector<SongEvent> &events,
+                 const std::vector<uint64_t> &onsets) {
+  std::vector<std::size_t> order(events.size());
+  std::iota(order.begin(), order.end(), std::size_t{0});
+  std::stable_sort(order.begin(), order.end(),
+                   [&](std::size_t a, std::size_t b) {
+                     return onsets[a] < onsets[b];
+                   });
+  std::vector<SongEvent> merged;
+  merged.reserve(events.size());
+  uint64_t previous = 0;
+  for (std::size_t index : order) {
+    merged.push_back(events[index]);
+    merged.back().delayUs = static_cast<uint32_t>(onsets[index] - previous);
+    previous = onsets[index];
+  }
+  events = std::move(merged);
+}
+} // namespace
+
+SongParseError::SongParseError(std::size_t line, std::size_t column,
+                               const std::string &message)
+    : std::runtime_error(std::to_string(line) + ":" + std::to_string(column) +
+                         ": " + message),
+      line_(line), column_(column) {}
+
+SongCompiler::SongCompiler(double sampleRate, const pitch::Table &tuning)
+    : sampleRate_(sampleRate), tuning_(tuning) {}
+
+std::vector<SongEvent> SongCompiler::compile(std::istream &input) const {
+  const std::string text{std::istreambuf_iterator<char>(input),
+                         std::istreambuf_iterator<char>()};
+  return compile(text);
+}
+
+std::vector<SongEvent> SongCompiler::compileFile(const std::string &path) const {
+  const MappedFile file(path);
+  return compile(file.view());
+}
+
+std::vector<SongEvent> SongCompiler::compile(std::string_view text) const {
+  SongParser parser(sampleRate_, tuning_);
+  ScoreTokenizer tokenizer(text);
+  std::vector<SongEvent> events;
+  events.reserve(text.size() / 6); // a typical "C 4 q\n" line is ~6 bytes
+
+  // Onsets are only needed to merge parallel tracks, which most scores lack.
+  std::vector<uint64_t> onsets;
+  std::size_t track = 0;
+  uint64_t trackTimeUs = 0;
+
+  ScoreTokenizer::Token token;
+  SongEvent event;
+  while (tokenizer.next(token)) {
+    if (!parser.feed(token, event))
+      continue;
+    if (parser.track() != track) {
+      if (onsets.empty()) {
+        // First parallel track: recover the onsets of everything so far.
+        uint64_t time = 0;
+        for (const SongEvent &earlier : events)
+          onsets.push_back(time += earlier.delayUs);
+      }
+      track = parser.track();
+      trackTimeUs = 0;
+    }
+    trackTimeUs += event.delayUs;
+    if (track != 0)
+      onsets.push_back(trackTimeUs);
+    events.push_back(event);
+  }
+  parser.finish(tokenizer.line(), tokenizer.column());
+  if (!onsets.empty())
+    mergeTracks(events, onsets);
+  return events;
+}
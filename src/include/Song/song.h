@@ -0,0 +1,75 @@
+#pragma once
+
+#include "../Pitch/pitch.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// One fully resolved score entry. The compiler computes everything playback
+// needs up front, so the player only walks a flat array of these.
+//
+// Events are ordered by onset. Each starts `delayUs` after the previous one
+// and sounds for `durationUs`; the two only differ where notes overlap, as in
+// chords and parallel tracks.
+struct SongEvent {
+  enum class Kind : uint8_t { Note, Rest };
+
+  Kind kind;
+  uint8_t midi;        // MIDI note number, 0 for rests
+  uint8_t fractionary; // 1 = whole, 2 = half, ... 64 = sixty-fourth
+  int8_t octave;
+  char name[3];  // note name as written ("C", "C#", "Bb"), NUL-terminated
+  char value[3]; // note value as written ("q", "sf"), NUL-terminated
+  uint16_t bpm;
+  float frequency; // Hz, 0 for rests
+  uint32_t durationUs;
+  uint32_t durationSamples;
+  uint32_t delayUs; // onset relative to the previous event's onset
+};
+static_assert(sizeof(SongEvent) == 28, "SongEvent should stay compact");
+
+constexpr uint32_t durationToSamples(uint32_t durationUs, double sampleRate) {
+  return static_cast<uint32_t>(durationUs * sampleRate / 1e6 + 0.5);
+}
+
+// Frame at which a song-relative time falls; 64-bit for long sessions.
+inline uint64_t usToFrames(uint64_t us, double sampleRate) {
+  return static_cast<uint64_t>(us * sampleRate / 1e6 + 0.5);
+}
+
+class SongParseError : public std::runtime_error {
+public:
+  SongParseError(std::size_t line, std::size_t column,
+                 const std::string &message);
+  std::size_t line() const { return line_; }
+  std::size_t column() const { return column_; }
+
+private:
+  std::size_t line_;
+  std::size_t column_;
+};
+
+class SongCompiler {
+public:
+  static constexpr double DEFAULT_SAMPLE_RATE = 48000.0;
+  static constexpr int DEFAULT_BPM = 100;
+
+  explicit SongCompiler(double sampleRate = DEFAULT_SAMPLE_RATE,
+                        const pitch::Table &tuning = pitch::EQUAL_TEMPERAMENT);
+
+  // Parses the whole score and throws SongParseError on the first malformed
+  // entry, so nothing is played from a broken file.
+  std::vector<SongEvent> compile(std::istream &input) const;
+  std::vector<SongEvent> compile(std::string_view text) const;
+  // Memory-maps the file instead of going through iostreams.
+  std::vector<SongEvent> compileFile(const std::string &path) const;
+
+private:
+  double sampleRate_;
+  pitch::Table tuning_;
+};
@@ -0,0 +1,207 @@
+#pragma once
+
+#include "../NotePlayer/noteplayer.h"
+#include "../Pitch/pitch.h"
+#include "scoretokenizer.h"
+#include "song.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// What SongParser does with a malformed score: throw SongParseError. The
+// message names the offending token, if any, in quotes.
+struct ThrowParseError {
+  [[noreturn]] static void fail(std::size_t line, std::size_t column,
+                                const char *message, std::string_view token) {
+    if (token.empty())
+      throw SongParseError(line, column, message);
+    throw SongParseError(line, column,
+                         std::string(message) + " '" + std::string(token) +
+                             "'");
+  }
+};
+
+// Incremental form of the score grammar: tokens are pushed in one at a time
+// and an event comes out whenever a 'P' or note entry is complete. This lets
+// the same rules serve whole files and endless streams alike.
+//
+// An entry preceded by '&' starts together with the entry before it, forming
+// a chord; the next entry starts once the longest member has ended. 'track'
+// starts another part that plays in parallel from the beginning of the song.
+// Events are emitted per track in the order written, with `delayUs` relative
+// to the previous event of the same track; merging tracks is up to the
+// caller.
+//
+// Everything is constexpr, so a score can also be parsed while the program
+// is compiled (see embeddedscore.h). `Errors::fail(line, column, message,
+// token)` reports malformed input and must not return at run time.
+template <typename Errors> class BasicSongParser {
+public:
+  constexpr explicit BasicSongParser(
+      double sampleRate, const pitch::Table &tuning = pitch::EQUAL_TEMPERAMENT)
+      : tuning_(tuning), sampleRate_(sampleRate) {}
+
+  // Returns true when `token` completed an event, which is stored in `event`.
+  constexpr bool feed(const ScoreTokenizer::Token &token, SongEvent &event) {
+    switch (state_) {
+    case State::Command:
+      if (token.text == "bpm") {
+        state_ = State::Tempo;
+      } else if (token.text == "&") {
+        if (!trackStarted_ || chordNext_)
+          Errors::fail(token.line, token.column,
+                       "'&' must follow a note or rest", {});
+        chordNext_ = true;
+      } else if (token.text == "track") {
+        if (chordNext_)
+          Errors::fail(token.line, token.column,
+                       "expected a note or rest after '&'", {});
+        ++track_;
+        trackStarted_ = false;
+        stepUs_ = 0;
+      } else if (token.text == "P") {
+        state_ = State::RestValue;
+      } else {
+        noteOffset_ = pitch::noteOffset(token.text);
+        if (noteOffset_ < 0)
+          Errors::fail(token.line, token.column, "unknown note or command",
+                       token.text);
+        copyName(noteName_, token.text);
+        state_ = State::NoteOctave;
+      }
+      return false;
+
+    case State::Tempo: {
+      int bpm = 0;
+      if (!parseInt(token.text, bpm) || bpm <= 0 || bpm > UINT16_MAX)
+        Errors::fail(token.line, token.column, "invalid tempo", token.text);
+      bpm_ = bpm;
+      state_ = State::Command;
+      return false;
+    }
+
+    case State::RestValue:
+      event = makeEvent(SongEvent::Kind::Rest, token);
+      state_ = State::Command;
+      return true;
+
+    case State::NoteOctave: {
+      int octave = 0;
+      const bool octaveOk =
+          parseInt(token.text, octave) && octave >= -1 && octave <= 9;
+      midi_ = pitch::midiNumber(noteOffset_, octave);
+      if (!octaveOk || midi_ > 127)
+        Errors::fail(token.line, token.column, "invalid octave", token.text);
+      state_ = State::NoteValue;
+      return false;
+    }
+
+    case State::NoteValue:
+      event = makeEvent(SongEvent::Kind::Note, token);
+      event.midi = static_cast<uint8_t>(midi_);
+      event.octave = static_cast<int8_t>(midi_ / 12 - 1);
+      event.frequency = tuning_[static_cast<std::size_t>(midi_)];
+      copyName(event.name, std::string_view(noteName_));
+      state_ = State::Command;
+      return true;
+    }
+    return false;
+  }
+
+  // Call once input is exhausted; fails if an entry was left unfinished.
+  constexpr void finish(std::size_t line, std::size_t column) const {
+    const char *message = nullptr;
+    switch (state_) {
+    case State::Command:
+      if (!chordNext_)
+        return;
+      message = "unexpected end of file, expected a note or rest after '&'";
+      break;
+    case State::Tempo:
+      message = "unexpected end of file, expected a tempo after 'bpm'";
+      break;
+    case State::RestValue:
+      message = "unexpected end of file, expected a note value after 'P'";
+      break;
+    case State::NoteOctave:
+      message = "unexpected end of file, expected an octave after the note "
+                "name";
+      break;
+    case State::NoteValue:
+      message = "unexpected end of file, expected a note value after the "
+                "octave";
+      break;
+    }
+    Errors::fail(line, column, message, {});
+  }
+
+  constexpr int bpm() const { return bpm_; }
+  // Index of the track being parsed, 0 until the first 'track'.
+  constexpr std::size_t track() const { return track_; }
+
+private:
+  enum class State { Command, Tempo, RestValue, NoteOctave, NoteValue };
+
+  // Decimal, optionally negative; anything over 100000 is refused.
+  static constexpr bool parseInt(std::string_view text, int &out) {
+    std::size_t pos = text.size() > 1 && text[0] == '-' ? 1 : 0;
+    if (pos == text.size())
+      return false;
+    long value = 0;
+    for (; pos < text.size(); ++pos) {
+      if (text[pos] < '0' || text[pos] > '9' || value > 100000)
+        return false;
+      value = value * 10 + (text[pos] - '0');
+    }
+    out = static_cast<int>(text[0] == '-' ? -value : value);
+    return true;
+  }
+
+  static constexpr void copyName(char (&dst)[3], std::string_view src) {
+    for (std::size_t i = 0; i < sizeof(dst); ++i)
+      dst[i] = i + 1 < sizeof(dst) && i < src.size() ? src[i] : '\0';
+  }
+
+  constexpr SongEvent makeEvent(SongEvent::Kind kind,
+                                const ScoreTokenizer::Token &valueToken) {
+    const int fractionary = NotePlayer::parseFractionary(valueToken.text);
+    if (fractionary == 0)
+      Errors::fail(valueToken.line, valueToken.column, "invalid note value",
+                   valueToken.text);
+    SongEvent event{};
+    event.kind = kind;
+    event.fractionary = static_cast<uint8_t>(fractionary);
+    event.bpm = static_cast<uint16_t>(bpm_);
+    event.durationUs = static_cast<uint32_t>(NotePlayer::TIME_US_QUAD /
+                                             (bpm_ * fractionary));
+    event.durationSamples = durationToSamples(event.durationUs, sampleRate_);
+    copyName(event.value, valueToken.text);
+    if (chordNext_) {
+      event.delayUs = 0;
+      stepUs_ = std::max(stepUs_, event.durationUs);
+    } else {
+      event.delayUs = stepUs_;
+      stepUs_ = event.durationUs;
+    }
+    chordNext_ = false;
+    trackStarted_ = true;
+    return event;
+  }
+
+  pitch::Table tuning_;
+  double sampleRate_;
+  State state_ = State::Command;
+  int bpm_ = SongCompiler::DEFAULT_BPM;
+  int noteOffset_ = 0;
+  int midi_ = 0;
+  char noteName_[3] = {};
+  std::size_t track_ = 0;
+  bool chordNext_ = false;    // the next entry joins the current chord
+  bool trackStarted_ = false; // an entry has been emitted in this track
+  uint32_t stepUs_ = 0;       // length of the current chord or single entry
+};
+
+using SongParser = BasicSongParser<ThrowParseError>;
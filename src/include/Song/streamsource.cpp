@@ -0,0 +1,149 @@
+#include "streamsource.h"
+#include "scoretokenizer.h"
+#include "songparser.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+
+StreamEventSource::StreamEventSource(int fd, double sampleRate,
+                                     const pitch::Table &tuning)
+    : fd_(fd), sampleRate_(sampleRate), tuning_(tuning), stop_(false),
+      done_(false),
+      underruns_(0), stepUs_(0), afterUnderrun_(false) {
+  reader_ = std::thread(&StreamEventSource::readerLoop, this);
+}
+
+StreamEventSource::~StreamEventSource() {
+  stop_.store(true, std::memory_order_relaxed);
+  if (reader_.joinable())
+    reader_.join();
+  close(fd_);
+}
+
+bool StreamEventSource::next(SongEvent &event) {
+  // The event returned last sounds for stepUs_ from now, so the producer has
+  // until then to deliver the next one before playback falls behind.
+  const auto stepEnd =
+      std::chrono::steady_clock::now() + std::chrono::microseconds(stepUs_);
+  bool popped = ring_.pop(event);
+  if (!popped) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    pushed_.wait_until(lock, stepEnd, [&] {
+      popped = ring_.pop(event);
+      return popped || done_.load(std::memory_order_acquire);
+    });
+  }
+  // The reader may have pushed its last events just before finishing.
+  if (!popped && done_.load(std::memory_order_acquire)) {
+    popped = ring_.pop(event);
+    if (!popped) {
+      if (error_)
+        std::rethrow_exception(error_);
+      return false;
+    }
+  }
+  if (popped) {
+    // A chord member still starts with whatever sounds now.
+    if (afterUnderrun_ && event.delayUs != 0)
+      event.delayUs = stepUs_;
+    afterUnderrun_ = false;
+    stepUs_ = event.delayUs != 0 ? event.durationUs
+                                 : std::max(stepUs_, event.durationUs);
+    return true;
+  }
+  ++underruns_;
+  event = SongEvent{};
+  event.kind = SongEvent::Kind::Rest;
+  event.durationUs = UNDERRUN_REST_US;
+  event.durationSamples = durationToSamples(UNDERRUN_REST_US, sampleRate_);
+  event.delayUs = stepUs_;
+  stepUs_ = UNDERRUN_REST_US;
+  afterUnderrun_ = true;
+  return true;
+}
+
+// Taking the lock orders the push before a waiting next() checks the ring
+// again, so the wake-up cannot be missed.
+void StreamEventSource::wakePlayback() {
+  { std::lock_guard<std::mutex> lock(mutex_); }
+  pushed_.notify_one();
+}
+
+void StreamEventSource::pushEvent(const SongEvent &event) {
+  // Back-pressure: a full ring means we are far enough ahead of playback.
+  while (!ring_.push(event)) {
+    if (stop_.load(std::memory_order_relaxed))
+      return;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  wakePlayback();
+}
+
+void StreamEventSource::readerLoop() {
+  try {
+    SongParser parser(sampleRate_, tuning_);
+    std::string pending;
+    pending.reserve(MAX_LINE + READ_CHUNK);
+    char chunk[READ_CHUNK];
+    std::size_t line = 1;
+    SongEvent event;
+
+    // Only whole lines are tokenized, so a token is never split between two
+    // reads and the tokenizer's columns stay right.
+    auto consume = [&](std::string_view text, bool atEof) {
+      ScoreTokenizer tokenizer(text, line);
+      ScoreTokenizer::Token token;
+      while (tokenizer.next(token)) {
+        const bool complete = parser.feed(token, event);
+        if (parser.track() != 0)
+          throw SongParseError(token.line, token.column,
+                               "parallel tracks need a score file, not a "
+                               "stream");
+        if (complete)
+          pushEvent(event);
+      }
+      if (atEof)
+        parser.finish(tokenizer.line(), tokenizer.column());
+      line = tokenizer.line();
+    };
+
+    while (!stop_.load(std::memory_order_relaxed)) {
+      pollfd pfd{fd_, POLLIN, 0};
+      const int ready = poll(&pfd, 1, 100);
+      if (ready == 0 || (ready == -1 && errno == EINTR))
+        continue;
+      if (ready == -1)
+        throw std::runtime_error("Failed to poll song stream");
+
+      const ssize_t n = read(fd_, chunk, sizeof(chunk));
+      if (n == -1) {
+        if (errno == EINTR || errno == EAGAIN)
+          continue;
+        throw std::runtime_error("Failed to read song stream");
+      }
+      if (n == 0) {
+        consume(pending, true);
+        break;
+      }
+      pending.append(chunk, static_cast<std::size_t>(n));
+      const std::size_t lastNewline = pending.rfind('\n');
+      if (lastNewline == std::string::npos) {
+        if (pending.size() > MAX_LINE)
+          throw SongParseError(line, 1, "line too long");
+        continue;
+      }
+      consume(std::string_view(pending).substr(0, lastNewline + 1), false);
+      pending.erase(0, lastNewline + 1);
+    }
+  } catch (...) {
+    error_ = std::current_exception();
+  }
+  done_.store(true, std::memory_order_release);
+  wakePlayback();
+}
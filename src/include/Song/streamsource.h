@@ -0,0 +1,63 @@
+#pragma once
+
+#include "../Pitch/pitch.h"
+#include "../SpscRing/spscring.h"
+#include "eventsource.h"
+#include "song.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+// Plays a score as it arrives on a pipe, FIFO or stdin. A reader thread
+// parses the input and fills a bounded ring that playback drains, so memory
+// use stays constant however long the stream runs. When the producer falls
+// behind, playback waits for it only until the step in progress ends, then
+// gets short rests, which keeps the silence between whole notes rather than
+// in the middle of one. Chords work as in files, but parallel tracks cannot
+// be merged without the whole score and are rejected.
+class StreamEventSource : public EventSource {
+public:
+  static constexpr std::size_t LOOKAHEAD_EVENTS = 256;
+  static constexpr uint32_t UNDERRUN_REST_US = 10000;
+
+  // Takes ownership of `fd`.
+  StreamEventSource(int fd, double sampleRate, const pitch::Table &tuning);
+  ~StreamEventSource() override;
+  StreamEventSource(const StreamEventSource &) = delete;
+  StreamEventSource &operator=(const StreamEventSource &) = delete;
+
+  // Meant to be called at the onset of the event it returned last. Throws
+  // the reader's SongParseError once the events before it are played.
+  bool next(SongEvent &event) override;
+  std::size_t underruns() const { return underruns_; }
+
+private:
+  static constexpr std::size_t READ_CHUNK = 16 * 1024;
+  static constexpr std::size_t MAX_LINE = 64 * 1024;
+
+  void readerLoop();
+  void pushEvent(const SongEvent &event);
+  void wakePlayback();
+
+  int fd_;
+  double sampleRate_;
+  pitch::Table tuning_;
+  SpscRing<SongEvent, LOOKAHEAD_EVENTS> ring_;
+  std::atomic<bool> stop_;
+  std::atomic<bool> done_;
+  std::exception_ptr error_; // set by the reader before done_
+  // Lets an empty ring be waited for; the reader signals each push and done_.
+  std::mutex mutex_;
+  std::condition_variable pushed_;
+  std::size_t underruns_;
+  // Playback side: length of the step last returned, so an underrun rest
+  // starts when it ends, and whether the next event must follow a rest.
+  uint32_t stepUs_;
+  bool afterUnderrun_;
+  std::thread reader_;
+};
@@ -0,0 +1,54 @@
+#include "dds.h"
+
+#include <array>
+#include <cmath>
+
+namespace osc {
+namespace dds {
+namespace {
+constexpr std::size_t LUT_SIZE = std::size_t{1} << LUT_BITS;
+constexpr double TWO_PI = 6.28318530717958647692;
+
+// Same shapes and polarity as the formula kernels, sampled at the start of
+// each table slot.
+double shape(Waveform waveform, double phase) {
+  switch (waveform) {
+  case Waveform::Square:
+    return phase < 0.5 ? 1.0 : -1.0;
+  case Waveform::Sawtooth:
+    return phase < 0.5 ? 2.0 * phase : 2.0 * phase - 2.0;
+  case Waveform::Triangle:
+    return 4.0 * std::abs(phase - std::floor(phase + 0.75) + 0.25) - 1.0;
+  case Waveform::Sine:
+  default:
+    return std::sin(TWO_PI * phase);
+  }
+}
+
+using Luts = std::array<std::array<int16_t, LUT_SIZE>, 4>;
+
+const Luts &luts() {
+  static const Luts built = [] {
+    Luts luts{};
+    for (int w = 0; w < 4; ++w)
+      for (std::size_t i = 0; i < LUT_SIZE; ++i)
+        luts[w][i] = static_cast<int16_t>(std::lround(
+            AMPLITUDE *
+            shape(static_cast<Waveform>(w), static_cast<double>(i) / LUT_SIZE)));
+    return luts;
+  }();
+  return built;
+}
+} // namespace
+
+uint32_t phaseIncrement(double frequency, double sampleRate) {
+  // Wraps like the phase itself; MIDI pitches stay far below Nyquist.
+  return static_cast<uint32_t>(
+      static_cast<uint64_t>(std::llround(frequency / sampleRate * 4294967296.0)));
+}
+
+const int16_t *lutFor(Waveform waveform) {
+  return luts()[static_cast<int>(waveform)].data();
+}
+} // namespace dds
+} // namespace osc
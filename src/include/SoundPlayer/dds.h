@@ -0,0 +1,34 @@
+#pragma once
+
+#include "oscillator.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Direct digital synthesis for hosts where float math is expensive: a 32-bit
+// phase accumulator that wraps on overflow, a per-note increment computed
+// once when the note is scheduled, and int16 samples read straight out of a
+// lookup table. No floating point runs per sample.
+namespace osc {
+namespace dds {
+constexpr int LUT_BITS = 12; // 4096 entries, 8 KB per waveform
+constexpr int PHASE_SHIFT = 32 - LUT_BITS;
+constexpr int16_t AMPLITUDE = 32767;
+
+// Phase step per sample for `frequency`, in units of 2^-32 cycles.
+uint32_t phaseIncrement(double frequency, double sampleRate);
+
+// Builds the tables on first use, so call it outside the audio callback.
+const int16_t *lutFor(Waveform waveform);
+
+inline void render(const int16_t *lut, int16_t *out, std::size_t frames,
+                   uint32_t &phase, uint32_t increment) {
+  uint32_t p = phase;
+  for (std::size_t i = 0; i < frames; ++i) {
+    out[i] = lut[p >> PHASE_SHIFT];
+    p += increment;
+  }
+  phase = p;
+}
+} // namespace dds
+} // namespace osc
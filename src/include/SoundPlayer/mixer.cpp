@@ -0,0 +1,157 @@
+#include "mixer.h"
+#include "dds.h"
+#include "wavetable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+Mixer::Mixer(osc::BlockKernel kernel, const int16_t *ddsLut)
+    : voices_{}, active_(0), kernel_(kernel), ddsLut_(ddsLut) {}
+
+Mixer Mixer::forSelection(char selection, bool dds) {
+  const osc::Waveform waveform = osc::waveformFromSelection(selection);
+  if (dds)
+    return Mixer(nullptr, osc::dds::lutFor(waveform));
+  if (osc::engineFromSelection(selection) == osc::Engine::Wavetable)
+    return Mixer(osc::wavetableKernel(waveform));
+  return Mixer(osc::kernelFor(waveform));
+}
+
+std::string Mixer::describeSelection(char selection, bool dds) {
+  const osc::Waveform waveform = osc::waveformFromSelection(selection);
+  const char *engine =
+      dds ? "dds"
+      : osc::engineFromSelection(selection) == osc::Engine::Wavetable
+          ? "wavetable"
+          : osc::isaName(osc::bestIsa());
+  return std::string(osc::waveformName(waveform)) + " (" + engine + ")";
+}
+
+void Mixer::noteOn(uint64_t frame, uint64_t endFrame, double increment,
+                   uint32_t ddsIncrement) {
+  Voice *slot = nullptr;
+  for (Voice &voice : voices_) {
+    if (!voice.active) {
+      slot = &voice;
+      break;
+    }
+    if (!slot || voice.start < slot->start)
+      slot = &voice;
+  }
+  if (!slot->active)
+    ++active_;
+  *slot = {frame, endFrame, increment, ddsIncrement, true};
+}
+
+void Mixer::advanceTo(uint64_t frame) {
+  for (Voice &voice : voices_) {
+    if (voice.active && voice.end <= frame) {
+      voice.active = false;
+      --active_;
+    }
+  }
+}
+
+void Mixer::releaseAll() {
+  for (Voice &voice : voices_)
+    voice.active = false;
+  active_ = 0;
+}
+
+std::size_t Mixer::pieceFrames(std::size_t frames, uint64_t frame) {
+  return std::min(frames, BLOCK - static_cast<std::size_t>(frame % BLOCK));
+}
+
+std::size_t Mixer::liveFrames(Voice &voice, std::size_t frames,
+                              uint64_t frame) {
+  const uint64_t left = voice.end > frame ? voice.end - frame : 0;
+  if (left > frames)
+    return frames;
+  voice.active = false;
+  --active_;
+  return static_cast<std::size_t>(left);
+}
+
+void Mixer::render(float *out, std::size_t frames, uint64_t frame) {
+  for (std::size_t done = 0; done < frames;) {
+    const std::size_t n = pieceFrames(frames - done, frame + done);
+    if (active_ == 0) {
+      std::memset(out + done, 0, n * sizeof(float));
+    } else {
+      std::memset(mix_, 0, n * sizeof(float));
+      for (Voice &voice : voices_) {
+        if (!voice.active)
+          continue;
+        const std::size_t live = liveFrames(voice, n, frame + done);
+        const double cycles =
+            static_cast<double>(frame + done - voice.start) * voice.increment;
+        double phase = cycles - std::floor(cycles);
+        kernel_(scratch_, live, phase, voice.increment);
+        mix::accumulate(mix_, scratch_, live, VOICE_GAIN);
+      }
+      mix::softClip(out + done, mix_, n);
+    }
+    done += n;
+  }
+}
+
+void Mixer::render(int16_t *out, std::size_t frames, uint64_t frame) {
+  for (std::size_t done = 0; done < frames;) {
+    const std::size_t n = pieceFrames(frames - done, frame + done);
+    if (active_ == 0) {
+      std::memset(out + done, 0, n * sizeof(int16_t));
+    } else {
+      std::memset(intMix_, 0, n * sizeof(int32_t));
+      for (Voice &voice : voices_) {
+        if (!voice.active)
+          continue;
+        const std::size_t live = liveFrames(voice, n, frame + done);
+        // Wrapping multiplication gives exactly the accumulated phase.
+        uint32_t phase = static_cast<uint32_t>(frame + done - voice.start) *
+                         voice.ddsIncrement;
+        osc::dds::render(ddsLut_, intScratch_, live, phase,
+                         voice.ddsIncrement);
+        mix::accumulate(intMix_, intScratch_, live);
+      }
+      mix::saturate(out + done, intMix_, n);
+    }
+    done += n;
+  }
+}
+
+namespace mix {
+// Plain loops over __restrict arrays: -O3 turns each into SIMD code for
+// whatever the baseline instruction set is.
+void accumulate(float *__restrict dst, const float *__restrict src,
+                std::size_t frames, float gain) {
+  for (std::size_t i = 0; i < frames; ++i)
+    dst[i] += gain * src[i];
+}
+
+void accumulate(int32_t *__restrict dst, const int16_t *__restrict src,
+                std::size_t frames) {
+  for (std::size_t i = 0; i < frames; ++i)
+    dst[i] += src[i];
+}
+
+void softClip(float *__restrict out, const float *__restrict in,
+              std::size_t frames) {
+  constexpr float knee = Mixer::CLIP_KNEE;
+  constexpr float range = 1.0f - knee;
+  for (std::size_t i = 0; i < frames; ++i) {
+    const float magnitude = std::fabs(in[i]);
+    // u / (1 + u) has slope 1 at the knee and approaches 1 from below.
+    const float u = std::max(magnitude - knee, 0.0f) / range;
+    const float shaped = std::min(magnitude, knee) + range * u / (1.0f + u);
+    out[i] = std::copysign(shaped, in[i]);
+  }
+}
+
+void saturate(int16_t *__restrict out, const int32_t *__restrict in,
+              std::size_t frames) {
+  static_assert(Mixer::VOICE_GAIN == 0.5f, "saturate() shifts by one");
+  for (std::size_t i = 0; i < frames; ++i)
+    out[i] = static_cast<int16_t>(std::clamp(in[i] >> 1, -32768, 32767));
+}
+} // namespace mix
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "oscillator.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Fixed pool of voices summed into one output. Everything is sized up front,
+// so rendering never allocates and is safe to run in the audio callback.
+// All voices share one oscillator: a float block kernel, or a DDS lookup
+// table when the stream is int16.
+class Mixer {
+public:
+  static constexpr std::size_t MAX_VOICES = 64;
+  static constexpr std::size_t BLOCK = 256; // frames mixed per pass
+  // A lone voice peaks at the soft clipper's knee, so it passes untouched;
+  // only overlapping voices get compressed.
+  static constexpr float VOICE_GAIN = 0.5f;
+  static constexpr float CLIP_KNEE = 0.5f;
+  static constexpr uint64_t SUSTAIN = UINT64_MAX; // end frame of held notes
+
+  explicit Mixer(osc::BlockKernel kernel = nullptr,
+                 const int16_t *ddsLut = nullptr);
+  // The oscillator picked by a player's waveform selection: Q/W/S/T use the
+  // formula kernels, q/w/s/t the wavetables, and `dds` the int16 tables.
+  static Mixer forSelection(char selection, bool dds);
+  // Human-readable form of the same choice, e.g. "sine (avx2)".
+  static std::string describeSelection(char selection, bool dds);
+  bool dds() const { return ddsLut_ != nullptr; }
+
+  // Starts a voice at stream frame `frame` that falls silent at `endFrame`.
+  // When every voice is busy the oldest one is taken over.
+  void noteOn(uint64_t frame, uint64_t endFrame, double increment,
+              uint32_t ddsIncrement);
+  void releaseAll();
+  // Retires the voices that end by `frame` without rendering anything, which
+  // leaves the pool exactly as rendering up to `frame` would.
+  void advanceTo(uint64_t frame);
+  std::size_t activeVoices() const { return active_; }
+
+  // Mixes `frames` samples starting at stream frame `frame`. Voices are
+  // started from the caller at their exact frame, so a render never has to
+  // begin one part-way through.
+  //
+  // Work is cut at every multiple of BLOCK frames, and each voice's phase is
+  // computed from its start frame at the beginning of every piece rather
+  // than carried over. The output therefore depends only on the notes and on
+  // where the caller splits its calls, so ranges that start on a BLOCK
+  // boundary can be rendered separately and still match a serial render bit
+  // for bit.
+  void render(float *out, std::size_t frames, uint64_t frame);
+  void render(int16_t *out, std::size_t frames, uint64_t frame);
+
+private:
+  struct Voice {
+    uint64_t start;
+    uint64_t end;
+    double increment;
+    uint32_t ddsIncrement;
+    bool active;
+  };
+
+  // Frames up to the next BLOCK boundary, at most `frames`.
+  static std::size_t pieceFrames(std::size_t frames, uint64_t frame);
+  // How many of the next `frames` samples `voice` still sounds for,
+  // retiring it if it ends within them.
+  std::size_t liveFrames(Voice &voice, std::size_t frames, uint64_t frame);
+
+  std::array<Voice, MAX_VOICES> voices_;
+  std::size_t active_;
+  osc::BlockKernel kernel_;
+  const int16_t *ddsLut_;
+  alignas(64) float mix_[BLOCK];
+  alignas(64) float scratch_[BLOCK];
+  alignas(64) int32_t intMix_[BLOCK];
+  alignas(64) int16_t intScratch_[BLOCK];
+};
+
+namespace mix {
+// dst[i] += gain * src[i]
+void accumulate(float *__restrict dst, const float *__restrict src,
+                std::size_t frames, float gain);
+void accumulate(int32_t *__restrict dst, const int16_t *__restrict src,
+                std::size_t frames);
+// Linear up to Mixer::CLIP_KNEE, then bends smoothly towards +-1.
+void softClip(float *__restrict out, const float *__restrict in,
+              std::size_t frames);
+// Applies Mixer::VOICE_GAIN and saturates to int16; the DDS path stays
+// integer-only, so it clips hard instead.
+void saturate(int16_t *__restrict out, const int32_t *__restrict in,
+              std::size_t frames);
+} // namespace mix
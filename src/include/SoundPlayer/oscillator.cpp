@@ -0,0 +1,88 @@
+#include "oscillator.h"
+#include "oscillatorkernels.h"
+
+#include <cctype>
+
+namespace osc {
+#if defined(__x86_64__) || defined(__i386__)
+// Defined in oscillator_avx2.cpp, which is built with -mavx2.
+BlockKernel avx2Kernel(Waveform waveform);
+#endif
+
+Waveform waveformFromSelection(char selection) {
+  switch (std::toupper(static_cast<unsigned char>(selection))) {
+  case 'Q':
+    return Waveform::Square;
+  case 'W':
+    return Waveform::Sawtooth;
+  case 'T':
+    return Waveform::Triangle;
+  case 'S':
+  default:
+    return Waveform::Sine;
+  }
+}
+
+Engine engineFromSelection(char selection) {
+  return std::islower(static_cast<unsigned char>(selection)) ? Engine::Wavetable
+                                                              : Engine::Formula;
+}
+
+const char *waveformName(Waveform waveform) {
+  switch (waveform) {
+  case Waveform::Square:
+    return "square";
+  case Waveform::Sawtooth:
+    return "sawtooth";
+  case Waveform::Triangle:
+    return "triangle";
+  case Waveform::Sine:
+  default:
+    return "sine";
+  }
+}
+
+const char *engineName(Engine engine) {
+  return engine == Engine::Wavetable ? "wavetable" : "formula";
+}
+
+Isa bestIsa() {
+#if defined(__x86_64__) || defined(__i386__)
+  if (__builtin_cpu_supports("avx2"))
+    return Isa::Avx2;
+  return Isa::Sse;
+#elif defined(__ARM_NEON) || defined(__SSE2__)
+  return Isa::Sse;
+#else
+  return Isa::Scalar;
+#endif
+}
+
+const char *isaName(Isa isa) {
+  switch (isa) {
+  case Isa::Avx2:
+    return "avx2";
+  case Isa::Sse:
+    return "sse/neon";
+  case Isa::Scalar:
+  default:
+    return "scalar";
+  }
+}
+
+BlockKernel kernelFor(Waveform waveform, Isa isa) {
+  if (isa > bestIsa())
+    isa = bestIsa();
+  switch (isa) {
+#if defined(__x86_64__) || defined(__i386__)
+  case Isa::Avx2:
+    return avx2Kernel(waveform);
+#endif
+  case Isa::Sse:
+    return kernelTable<4>(waveform);
+  case Isa::Scalar:
+  default:
+    return kernelTable<1>(waveform);
+  }
+}
+} // namespace osc
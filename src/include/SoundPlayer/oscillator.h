@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Block oscillators: each kernel fills a whole buffer for one waveform, with
+// the waveform fixed at compile time, so the audio callback makes one call
+// per buffer instead of one indirect call per sample.
+namespace osc {
+enum class Waveform : uint8_t { Sine, Square, Sawtooth, Triangle };
+enum class Isa : uint8_t { Scalar, Sse, Avx2 };
+// Formula evaluates the waveform per sample and aliases at high notes;
+// Wavetable plays band-limited tables (wavetable.h).
+enum class Engine : uint8_t { Formula, Wavetable };
+
+// Writes `frames` samples in [-1, 1] starting at `phase` (cycles, [0, 1)),
+// advancing by `increment` cycles per sample (< 0.5 below Nyquist), and
+// stores the phase to resume from. Samples are computed in float, but the
+// phase carried between calls stays double so long notes do not drift.
+using BlockKernel = void (*)(float *out, std::size_t frames, double &phase,
+                             double increment);
+
+// Maps the player's Q/W/S/T selection; anything else is sine. Lower-case
+// q/w/s/t pick the same waveform from the wavetable engine.
+Waveform waveformFromSelection(char selection);
+Engine engineFromSelection(char selection);
+const char *waveformName(Waveform waveform);
+const char *engineName(Engine engine);
+
+// Widest instruction set this CPU can run.
+Isa bestIsa();
+const char *isaName(Isa isa);
+
+// Falls back to the next narrower set if `isa` is not available.
+BlockKernel kernelFor(Waveform waveform, Isa isa = bestIsa());
+} // namespace osc
@@ -0,0 +1,11 @@
+// Built with -mavx2 -mfma (see the Makefile); only called after
+// osc::bestIsa() has confirmed the CPU supports AVX2.
+#include "oscillator.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include "oscillatorkernels.h"
+
+namespace osc {
+BlockKernel avx2Kernel(Waveform waveform) { return kernelTable<8>(waveform); }
+} // namespace osc
+#endif
@@ -0,0 +1,116 @@
+#pragma once
+
+// Kernel bodies shared by oscillator.cpp and oscillator_avx2.cpp. Each of
+// those translation units is compiled for a different instruction set, so
+// everything here has internal linkage: the linker must never swap an AVX2
+// instantiation in for a baseline one.
+
+#include "oscillator.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+namespace osc {
+namespace {
+// GCC/Clang vector extensions: the same source becomes SSE, AVX or NEON
+// depending on how the translation unit is compiled.
+template <int Lanes> struct Vec {
+  typedef float type __attribute__((vector_size(Lanes * sizeof(float))));
+  typedef int32_t itype __attribute__((vector_size(Lanes * sizeof(float))));
+};
+template <> struct Vec<1> {
+  typedef float type;
+  typedef int32_t itype;
+};
+
+template <int Lanes> using VecF = typename Vec<Lanes>::type;
+
+// All waveform arguments are non-negative, so truncation is floor.
+template <int Lanes> inline VecF<Lanes> floorPos(VecF<Lanes> x) {
+  if constexpr (Lanes == 1) {
+    return static_cast<float>(static_cast<int32_t>(x));
+  } else {
+    return __builtin_convertvector(
+        __builtin_convertvector(x, typename Vec<Lanes>::itype), VecF<Lanes>);
+  }
+}
+
+template <int Lanes> inline VecF<Lanes> absf(VecF<Lanes> x) {
+  if constexpr (Lanes == 1) {
+    return std::fabs(x);
+  } else {
+    return x < 0.0f ? -x : x;
+  }
+}
+
+template <int Lanes> inline VecF<Lanes> broadcast(float x) {
+  return VecF<Lanes>{} + x;
+}
+
+template <Waveform W, int Lanes> inline VecF<Lanes> shape(VecF<Lanes> p) {
+  if constexpr (W == Waveform::Sine) {
+    // Folding the phase into a triangle t in [-1, 1] gives
+    // sin(2*pi*p) == sin(pi/2 * t), which an odd polynomial covers to ~4e-6.
+    const VecF<Lanes> q = p + 0.25f;
+    const VecF<Lanes> t = 1.0f - 4.0f * absf<Lanes>(q - floorPos<Lanes>(q) - 0.5f);
+    const VecF<Lanes> t2 = t * t;
+    return t * (1.57079633f +
+                t2 * (-0.64596409f +
+                      t2 * (0.07969262f +
+                            t2 * (-0.00468175f + t2 * 0.00016044f))));
+  } else if constexpr (W == Waveform::Square) {
+    return 1.0f - 2.0f * floorPos<Lanes>(2.0f * p);
+  } else if constexpr (W == Waveform::Sawtooth) {
+    return 2.0f * (p - floorPos<Lanes>(p + 0.5f));
+  } else {
+    return 4.0f * absf<Lanes>(p - floorPos<Lanes>(p + 0.75f) + 0.25f) - 1.0f;
+  }
+}
+
+template <Waveform W, int Lanes>
+void renderBlock(float *out, std::size_t frames, double &phase,
+                 double increment) {
+  const float start = static_cast<float>(phase);
+  const float inc = static_cast<float>(increment);
+  std::size_t i = 0;
+  float p = start;
+  if constexpr (Lanes > 1) {
+    VecF<Lanes> lanes;
+    for (int lane = 0; lane < Lanes; ++lane)
+      lanes[lane] = start + lane * inc;
+    lanes -= floorPos<Lanes>(lanes);
+    const VecF<Lanes> step = broadcast<Lanes>(inc * Lanes);
+    for (; i + Lanes <= frames; i += Lanes) {
+      const VecF<Lanes> y = shape<W, Lanes>(lanes);
+      std::memcpy(out + i, &y, sizeof(y));
+      lanes += step;
+      lanes -= floorPos<Lanes>(lanes);
+    }
+    p = lanes[0];
+  }
+  for (; i < frames; ++i) {
+    out[i] = shape<W, 1>(p);
+    p += inc;
+    if (p >= 1.0f)
+      p -= 1.0f;
+  }
+  phase += static_cast<double>(frames) * increment;
+  phase -= std::floor(phase);
+}
+
+template <int Lanes> BlockKernel kernelTable(Waveform waveform) {
+  switch (waveform) {
+  case Waveform::Square:
+    return renderBlock<Waveform::Square, Lanes>;
+  case Waveform::Sawtooth:
+    return renderBlock<Waveform::Sawtooth, Lanes>;
+  case Waveform::Triangle:
+    return renderBlock<Waveform::Triangle, Lanes>;
+  case Waveform::Sine:
+  default:
+    return renderBlock<Waveform::Sine, Lanes>;
+  }
+}
+} // namespace
+} // namespace osc
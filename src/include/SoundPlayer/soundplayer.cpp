@@ -1,118 +1,213 @@
 #include "soundplayer.h"
-#include <cmath>
-#include <functional>
+#include "dds.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
+#include <thread>
+#include <utility>
+
+SoundPlayer::SoundPlayer(char type, bool dds, const std::string &sink)
+    : sink_(makeAudioSink(sink, SAMPLE_RATE,
+                          dds ? AudioSink::Format::Int16
+                              : AudioSink::Format::Float32)),
+      songBaseFrame_(0), songOriginNs_(0), dds_(dds), bufferGiven_(false) {
+  data_.mixer = Mixer::forSelection(type, dds);
+  std::cout << "chosen " << Mixer::describeSelection(type, dds) << " on "
+            << sink_->description() << std::endl;
+  sink_->start(dds ? renderBuffer<int16_t> : renderBuffer<float>, &data_);
+}
 
-std::function<double(double)> SoundPlayer::waveFunc = nullptr;
+// The sink stops first: its thread reads data_ until then.
+SoundPlayer::~SoundPlayer() { sink_->stop(); }
 
-inline double sineWave(double phase) { return std::sin(2.0 * M_PI * phase); }
+void SoundPlayer::stopTone() {
+  data_.buffer.store(nullptr, std::memory_order_release);
+  pushCommand(toneCommand(0, 0, 0.0));
+}
 
-inline double sawtoothWave(double phase) {
-  return 2.0 * (phase - static_cast<int>(phase + 0.5));
+void SoundPlayer::beginSong() {
+  songBaseFrame_ = data_.framesRendered.load(std::memory_order_acquire) +
+                   static_cast<uint64_t>(SAMPLE_RATE * lookaheadMs() / 1000);
+  songOriginNs_ = heardNs(0);
 }
 
-inline double squareWave(double phase) {
-  return 4.0 * static_cast<int>(phase) - 2.0 * static_cast<int>(2 * phase) +
-         1.0;
+// Before the first buffer, the next frame is taken to be rendered now.
+int64_t SoundPlayer::frameZeroNs() const {
+  const int64_t zeroNs = data_.frameZeroNs.load(std::memory_order_relaxed);
+  if (zeroNs != 0)
+    return zeroNs;
+  return Scheduler::nowNs() -
+         framesToNs(data_.framesRendered.load(std::memory_order_acquire));
 }
 
-inline double triangleWave(double phase) {
-  return 4.0 * std::abs(phase - std::floor(phase + 0.75) + 0.25) - 1.0;
+int64_t SoundPlayer::heardNs(uint64_t songFrame) const {
+  return frameZeroNs() + framesToNs(songBaseFrame_ + songFrame) +
+         static_cast<int64_t>(sink_->bufferSeconds() * 1e9);
 }
 
-SoundPlayer::SoundPlayer(char type) : stream_(nullptr), data_{0.0, 0.0} {
-  PaError err = Pa_Initialize();
-  if (err != paNoError) {
-    throw std::runtime_error("PortAudio initialization failed");
-  }
-  switch (type) {
-  case 'S':
-    std::cout << "chosen sine" << std::endl;
-    waveFunc = sineWave;
-    break;
-  case 'W':
-    std::cout << "chosen sawtooth" << std::endl;
-    waveFunc = sawtoothWave;
-    break;
-  case 'Q':
-    std::cout << "chosen square" << std::endl;
-    waveFunc = squareWave;
-    break;
-  case 'T':
-    std::cout << "chosen triangle" << std::endl;
-    waveFunc = triangleWave;
-    break;
-  default:
-    std::cout << "chosen sine" << std::endl;
-    waveFunc = sineWave;
-    break;
-  }
+bool SoundPlayer::popOnset(Onset &onset) {
+  OnsetReport report;
+  if (!data_.onsets.pop(report))
+    return false;
+  const int64_t latencyNs = static_cast<int64_t>(sink_->bufferSeconds() * 1e9);
+  onset.scheduledNs = songFrameNs(report.frame - songBaseFrame_);
+  onset.heardNs =
+      report.frameZeroNs + framesToNs(report.startedFrame) + latencyNs;
+  onset.endHeardNs =
+      report.frameZeroNs +
+      framesToNs(std::max(report.endFrame, report.startedFrame)) + latencyNs;
+  return true;
 }
 
-SoundPlayer::~SoundPlayer() {
-  if (stream_) {
-    Pa_CloseStream(stream_);
-  }
-  Pa_Terminate();
+int SoundPlayer::lookaheadMs() const {
+  return LOOKAHEAD_MS +
+         static_cast<int>(std::ceil(sink_->bufferSeconds() * 1000));
 }
 
-void SoundPlayer::playTone(double frequency, int duration_ms) {
-  data_.phase = 0.0;
-  data_.frequency = frequency;
+void SoundPlayer::scheduleNote(uint64_t songFrame, uint64_t endSongFrame,
+                               double frequency) {
+  pushCommand(toneCommand(songBaseFrame_ + songFrame,
+                          songBaseFrame_ + endSongFrame, frequency));
+}
 
-  PaStreamParameters outputParameters;
-  outputParameters.device = Pa_GetDefaultOutputDevice();
-  if (outputParameters.device == paNoDevice) {
-    throw std::runtime_error("No default output device");
-  }
-  outputParameters.channelCount = 1;
-  outputParameters.sampleFormat = paFloat32;
-  outputParameters.suggestedLatency =
-      Pa_GetDeviceInfo(outputParameters.device)->defaultLowOutputLatency;
-  outputParameters.hostApiSpecificStreamInfo = nullptr;
-
-  PaError err = Pa_OpenStream(&stream_, nullptr, &outputParameters, SAMPLE_RATE,
-                              paFramesPerBufferUnspecified, paClipOff,
-                              paCallback, &data_);
-  if (err != paNoError) {
-    throw std::runtime_error("Failed to open stream");
+void SoundPlayer::finishSong(uint64_t endSongFrame) {
+  const uint64_t endFrame = songBaseFrame_ + endSongFrame;
+  for (;;) {
+    const uint64_t rendered =
+        data_.framesRendered.load(std::memory_order_acquire);
+    if (rendered >= endFrame)
+      break;
+    // Sleep for what is left, but wake at least every buffer or so in case
+    // the sink runs behind the sample rate.
+    const double leftMs = (endFrame - rendered) * 1000.0 / SAMPLE_RATE;
+    std::this_thread::sleep_for(std::chrono::microseconds(
+        static_cast<int64_t>(std::clamp(leftMs, 1.0, 20.0) * 1000)));
   }
+  // Stopping drains: PortAudio plays its queued buffers first, and a paced
+  // sink has already handed everything it rendered on.
+  sink_->stop();
+}
 
-  err = Pa_StartStream(stream_);
-  if (err != paNoError) {
-    throw std::runtime_error("Failed to start stream");
-  }
+void SoundPlayer::playBuffer(const float *samples, uint64_t frames,
+                             std::vector<NoteSpan> notes) {
+  if (dds_)
+    throw std::runtime_error("A DDS stream plays int16 samples, not float");
+  startBuffer(samples, frames, std::move(notes));
+}
 
-  Pa_Sleep(duration_ms);
+void SoundPlayer::playBuffer(const int16_t *samples, uint64_t frames,
+                             std::vector<NoteSpan> notes) {
+  if (!dds_)
+    throw std::runtime_error("A float stream cannot play int16 samples");
+  startBuffer(samples, frames, std::move(notes));
+}
 
-  err = Pa_StopStream(stream_);
-  if (err != paNoError) {
-    throw std::runtime_error("Failed to stop stream");
-  }
+void SoundPlayer::startBuffer(const void *samples, uint64_t frames,
+                              std::vector<NoteSpan> notes) {
+  // The bounds are plain fields the callback reads once it sees `buffer`, so
+  // they can only be written before the first buffer is published.
+  if (bufferGiven_)
+    throw std::runtime_error("A SoundPlayer plays a single buffer");
+  bufferGiven_ = true;
+  data_.bufferStart = songBaseFrame_;
+  data_.bufferFrames = frames;
+  bufferNotes_ = std::move(notes);
+  data_.bufferNotes = bufferNotes_.data();
+  data_.bufferNoteCount = bufferNotes_.size();
+  data_.buffer.store(samples, std::memory_order_release);
+}
 
-  err = Pa_CloseStream(stream_);
-  if (err != paNoError) {
-    throw std::runtime_error("Failed to close stream");
-  }
+SoundPlayer::ToneCommand SoundPlayer::toneCommand(uint64_t frame,
+                                                  uint64_t endFrame,
+                                                  double frequency) const {
+  return {frame, endFrame, static_cast<float>(frequency),
+          dds_ ? osc::dds::phaseIncrement(frequency, SAMPLE_RATE) : 0};
+}
+
+void SoundPlayer::pushCommand(const ToneCommand &command) {
+  // The callback drains the queue every buffer, so it is only ever full if
+  // the stream has stalled; waiting here keeps note-offs from being lost.
+  while (!data_.commands.push(command))
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
 
-  stream_ = nullptr; // Reset the stream pointer
+template <typename Sample>
+void SoundPlayer::copyBuffer(Sample *out, unsigned long frames,
+                             const Sample *buffer, const PaData &data) {
+  // Silence before the song starts and after it ends, samples in between.
+  const uint64_t end = data.frame + frames;
+  const uint64_t from = std::clamp(data.bufferStart, data.frame, end);
+  const uint64_t to =
+      std::clamp(data.bufferStart + data.bufferFrames, data.frame, end);
+  const std::size_t lead = static_cast<std::size_t>(from - data.frame);
+  const std::size_t copied = static_cast<std::size_t>(to - from);
+  std::memset(out, 0, lead * sizeof(Sample));
+  std::memcpy(out + lead, buffer + (from - data.bufferStart),
+              copied * sizeof(Sample));
+  std::memset(out + lead + copied, 0,
+              (frames - lead - copied) * sizeof(Sample));
 }
 
-int SoundPlayer::paCallback(const void * /*inputBuffer*/, void *outputBuffer,
-                            unsigned long framesPerBuffer,
-                            const PaStreamCallbackTimeInfo * /*timeInfo*/,
-                            PaStreamCallbackFlags /*statusFlags*/,
-                            void *userData) {
-  float *out = static_cast<float *>(outputBuffer);
+template <typename Sample>
+void SoundPlayer::renderBuffer(void *outputBuffer,
+                               unsigned long framesPerBuffer, void *userData) {
+  Sample *out = static_cast<Sample *>(outputBuffer);
   PaData *data = static_cast<PaData *>(userData);
+  // This buffer is rendered now: the clock its notes are reported against.
+  const int64_t frameZeroNs = Scheduler::nowNs() - framesToNs(data->frame);
+  data->frameZeroNs.store(frameZeroNs, std::memory_order_relaxed);
+
+  if (const void *buffer = data->buffer.load(std::memory_order_acquire)) {
+    copyBuffer(out, framesPerBuffer, static_cast<const Sample *>(buffer),
+               *data);
+    const uint64_t bufferEnd = data->frame + framesPerBuffer;
+    for (; data->nextBufferNote < data->bufferNoteCount;
+         ++data->nextBufferNote) {
+      const NoteSpan &note = data->bufferNotes[data->nextBufferNote];
+      const uint64_t frame = data->bufferStart + note.frame;
+      if (frame >= bufferEnd)
+        break;
+      data->onsets.push({frame, std::max(frame, data->frame),
+                         data->bufferStart + note.endFrame, frameZeroNs});
+    }
+    data->frame += framesPerBuffer;
+    data->framesRendered.store(data->frame, std::memory_order_release);
+    return;
+  }
 
-  for (unsigned int i = 0; i < framesPerBuffer; ++i) {
-    *out++ = waveFunc(data->phase);
-    data->phase += data->frequency / SAMPLE_RATE;
-    if (data->phase >= 1.0)
-      data->phase -= 1.0;
+  unsigned long i = 0;
+  while (i < framesPerBuffer) {
+    // Apply every command that is due at the current frame.
+    while (true) {
+      if (!data->hasPending) {
+        if (!data->commands.pop(data->pending))
+          break;
+        data->hasPending = true;
+      }
+      if (data->pending.frame > data->frame + i)
+        break;
+      if (data->pending.frequency == 0.0f) {
+        data->mixer.releaseAll();
+      } else {
+        data->mixer.noteOn(data->frame + i, data->pending.endFrame,
+                           data->pending.frequency / SAMPLE_RATE,
+                           data->pending.increment);
+        data->onsets.push({data->pending.frame, data->frame + i,
+                           data->pending.endFrame, frameZeroNs});
+      }
+      data->hasPending = false;
+    }
+
+    // Render up to the next pending command or the end of the buffer.
+    unsigned long end = framesPerBuffer;
+    if (data->hasPending && data->pending.frame < data->frame + end)
+      end = static_cast<unsigned long>(data->pending.frame - data->frame);
+    data->mixer.render(out + i, end - i, data->frame + i);
+    i = end;
   }
 
-  return paContinue;
+  data->frame += framesPerBuffer;
+  data->framesRendered.store(data->frame, std::memory_order_release);
 }
@@ -1,32 +1,152 @@
 #pragma once
 
+#include "../AudioSink/audiosink.h"
+#include "../Song/song.h"
+#include "../SpscRing/spscring.h"
+#include "mixer.h"
+
+#include <atomic>
 #include <cmath>
+#include <cstdint>
 #include <cstdlib>
-#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 #define SAMPLE_RATE 48000.0 // anything higher should not be necessary
-#include <portaudio.h>
 
+// Owns one audio sink for its whole lifetime. Callers never touch the sink
+// directly: they queue notes stamped with the frames at which they start and
+// stop, and renderBuffer hands each one to a voice of the mixer at exactly
+// its start frame. Any number of notes may overlap, up to
+// Mixer::MAX_VOICES.
 class SoundPlayer {
 public:
-  SoundPlayer(char type);
+  // Song frame 0 is placed this far after beginSong(), which gives the
+  // caller that much slack to queue each command before it is due.
+  static constexpr int LOOKAHEAD_MS = 30;
+
+  // With `dds` the stream runs in int16 and every waveform is rendered by
+  // the fixed-point oscillator in dds.h instead of the float kernels.
+  // `sink` is a makeAudioSink() spec; by default the sound card is used.
+  SoundPlayer(char type, bool dds = false,
+              const std::string &sink = "portaudio");
   ~SoundPlayer();
+  SoundPlayer(const SoundPlayer &) = delete;
+  SoundPlayer &operator=(const SoundPlayer &) = delete;
+
+  // Applied at the next buffer: silences every voice and ends any
+  // playBuffer().
+  void stopTone();
+
+  // Sample-accurate scheduling on a song clock counted in frames.
+  static uint64_t framesFromUs(uint64_t us) {
+    return usToFrames(us, SAMPLE_RATE);
+  }
+  void beginSong();
+  // How far ahead of beginSong() song frame 0 is placed: LOOKAHEAD_MS plus
+  // whatever the sink buffers.
+  int lookaheadMs() const;
+  // CLOCK_MONOTONIC time at which a song frame leaves the sink. songFrameNs()
+  // is where it was meant to be by the output's clock at beginSong();
+  // heardNs() is where the latest buffer puts it.
+  int64_t songFrameNs(uint64_t songFrame) const {
+    return songOriginNs_ + framesToNs(songFrame);
+  }
+  int64_t heardNs(uint64_t songFrame) const;
 
-  void playTone(double frequency, int duration_ms);
+  // A note as the output actually placed it: the audio thread reports the
+  // frame it started each note at, and its buffer's clock times it.
+  struct Onset {
+    int64_t scheduledNs; // songFrameNs() of the frame it was scheduled for
+    int64_t heardNs;     // when its first frame leaves the sink
+    int64_t endHeardNs;  // when its end frame leaves the sink
+  };
+  // The oldest note started since the last call, if any. Reports the caller
+  // does not collect in time are dropped.
+  bool popOnset(Onset &onset);
+  // Timing of the sink's audio callbacks; readable from any thread.
+  const CallbackTelemetry &callbackTelemetry() const {
+    return sink_->telemetry();
+  }
+  void scheduleNote(uint64_t songFrame, uint64_t endSongFrame,
+                    double frequency);
+  // Blocks until the sink has rendered up to `endSongFrame`, then stops it
+  // once what it still buffers has played. No sound is made afterwards.
+  void finishSong(uint64_t endSongFrame);
+  // Plays a song rendered ahead of time from song frame 0 on; the callback
+  // then only copies samples. Only one buffer may be given. It must outlive
+  // the SoundPlayer and match the stream: int16_t with dds, float otherwise.
+  // `notes`, sorted by start, are reported through popOnset() as they play.
+  struct NoteSpan {
+    uint64_t frame;
+    uint64_t endFrame;
+  };
+  void playBuffer(const float *samples, uint64_t frames,
+                  std::vector<NoteSpan> notes = {});
+  void playBuffer(const int16_t *samples, uint64_t frames,
+                  std::vector<NoteSpan> notes = {});
 
 private:
-  static int paCallback(const void *inputBuffer, void *outputBuffer,
-                        unsigned long framesPerBuffer,
-                        const PaStreamCallbackTimeInfo *timeInfo,
-                        PaStreamCallbackFlags statusFlags, void *userData);
+  struct ToneCommand {
+    uint64_t frame;     // absolute stream frame; 0 means as soon as possible
+    uint64_t endFrame;  // absolute frame at which the note stops
+    float frequency;    // 0 silences every voice
+    uint32_t increment; // DDS phase step, computed on the caller's thread
+  };
+  static constexpr std::size_t COMMAND_QUEUE = 1024;
+  // A note as started by the audio thread, in absolute stream frames.
+  struct OnsetReport {
+    uint64_t frame;        // where it was scheduled
+    uint64_t startedFrame; // where it started, later if it came in late
+    uint64_t endFrame;
+    int64_t frameZeroNs; // the clock of the buffer that started it
+  };
 
-  PaStream *stream_;
-  static std::function<double(double)> waveFunc;
+  static int64_t framesToNs(uint64_t frames) {
+    return static_cast<int64_t>(frames * 1000000000 /
+                                static_cast<uint64_t>(SAMPLE_RATE));
+  }
+
+  template <typename Sample>
+  static void renderBuffer(void *outputBuffer, unsigned long framesPerBuffer,
+                           void *userData);
+  ToneCommand toneCommand(uint64_t frame, uint64_t endFrame,
+                          double frequency) const;
+  void startBuffer(const void *samples, uint64_t frames,
+                   std::vector<NoteSpan> notes);
+  void pushCommand(const ToneCommand &command);
+  int64_t frameZeroNs() const;
+
+  std::unique_ptr<AudioSink> sink_;
+  // Everything below `onsets` is owned by the audio thread.
   struct PaData {
-    double phase;
-    double frequency;
+    SpscRing<ToneCommand, COMMAND_QUEUE> commands;
+    std::atomic<uint64_t> framesRendered{0};
+    // When stream frame 0 would have been rendered, by the clock of the
+    // latest buffer; 0 until the first one.
+    std::atomic<int64_t> frameZeroNs{0};
+    // playBuffer(): written before `buffer` is published.
+    std::atomic<const void *> buffer{nullptr};
+    uint64_t bufferStart = 0;
+    uint64_t bufferFrames = 0;
+    const NoteSpan *bufferNotes = nullptr;
+    std::size_t bufferNoteCount = 0;
+    SpscRing<OnsetReport, COMMAND_QUEUE> onsets;
+    std::size_t nextBufferNote = 0;
+    Mixer mixer; // configured before the stream starts
+    uint64_t frame = 0;
+    ToneCommand pending{};
+    bool hasPending = false;
   } data_;
-
+  template <typename Sample>
+  static void copyBuffer(Sample *out, unsigned long frames,
+                         const Sample *buffer, const PaData &data);
+  std::vector<NoteSpan> bufferNotes_;
+  uint64_t songBaseFrame_;
+  int64_t songOriginNs_;
+  bool dds_;
+  bool bufferGiven_;
 };
@@ -0,0 +1,132 @@
+#include "wavetable.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+
+namespace osc {
+namespace wavetable {
+namespace {
+constexpr double TWO_PI = 6.28318530717958647692;
+constexpr double PI = TWO_PI / 2.0;
+// One guard sample per table so interpolation never wraps the index.
+constexpr std::size_t STRIDE = TABLE_SIZE + 1;
+
+struct Bank {
+  // [waveform][band][sample]
+  std::array<std::vector<float>, 4> tables;
+};
+
+// Amplitude of harmonic k of each waveform, matching the phase and polarity
+// of the formula kernels in oscillatorkernels.h.
+double harmonicAmplitude(Waveform waveform, int k) {
+  switch (waveform) {
+  case Waveform::Square:
+    return k % 2 ? 4.0 / (PI * k) : 0.0;
+  case Waveform::Sawtooth:
+    return (k % 2 ? 2.0 : -2.0) / (PI * k);
+  case Waveform::Triangle:
+    return k % 2 ? (k % 4 == 1 ? 8.0 : -8.0) / (PI * PI * k * k) : 0.0;
+  case Waveform::Sine:
+  default:
+    return k == 1 ? 1.0 : 0.0;
+  }
+}
+
+const Bank &bank() {
+  static const Bank built = [] {
+    std::vector<double> sine(TABLE_SIZE);
+    for (std::size_t i = 0; i < TABLE_SIZE; ++i)
+      sine[i] = std::sin(TWO_PI * i / TABLE_SIZE);
+
+    Bank bank;
+    std::vector<double> sum(TABLE_SIZE);
+    for (int w = 0; w < 4; ++w) {
+      const Waveform waveform = static_cast<Waveform>(w);
+      std::vector<float> &table = bank.tables[w];
+      table.resize(STRIDE * BANDS);
+      double peak = 0.0;
+      for (int band = 0; band < BANDS; ++band) {
+        std::fill(sum.begin(), sum.end(), 0.0);
+        for (int k = 1; k <= harmonicsFor(band); ++k) {
+          const double amplitude = harmonicAmplitude(waveform, k);
+          if (amplitude == 0.0)
+            continue;
+          // sin(2*pi*k*i/N) is an exact sample of the base sine table.
+          for (std::size_t i = 0; i < TABLE_SIZE; ++i)
+            sum[i] += amplitude * sine[(k * i) & (TABLE_SIZE - 1)];
+        }
+        for (std::size_t i = 0; i < TABLE_SIZE; ++i) {
+          table[band * STRIDE + i] = static_cast<float>(sum[i]);
+          peak = std::max(peak, std::abs(sum[i]));
+        }
+        table[band * STRIDE + TABLE_SIZE] = table[band * STRIDE];
+      }
+      // Gibbs overshoot pushes the square and sawtooth past 1; scale every
+      // band of a waveform alike so loudness does not jump between octaves.
+      if (peak > 1.0)
+        for (float &sample : table)
+          sample = static_cast<float>(sample / peak);
+    }
+    return bank;
+  }();
+  return built;
+}
+
+const Bank *g_bank = nullptr;
+
+template <Waveform W>
+void renderTable(float *out, std::size_t frames, double &phase,
+                 double increment) {
+  const float *table =
+      g_bank->tables[static_cast<int>(W)].data() + bandFor(increment) * STRIDE;
+  // 32-bit fixed-point phase inside the block: the top bits index the table,
+  // the rest interpolate, and overflow is the wrap.
+  constexpr int FRACTION_BITS = 32 - std::countr_zero(TABLE_SIZE);
+  constexpr float FRACTION_SCALE = 1.0f / (1u << FRACTION_BITS);
+  uint32_t p = static_cast<uint32_t>(
+      static_cast<uint64_t>(phase * 4294967296.0));
+  const uint32_t inc = static_cast<uint32_t>(increment * 4294967296.0);
+  for (std::size_t i = 0; i < frames; ++i) {
+    const uint32_t index = p >> FRACTION_BITS;
+    const float fraction =
+        static_cast<float>(p & ((1u << FRACTION_BITS) - 1)) * FRACTION_SCALE;
+    out[i] = table[index] + fraction * (table[index + 1] - table[index]);
+    p += inc;
+  }
+  phase += static_cast<double>(frames) * increment;
+  phase -= std::floor(phase);
+}
+} // namespace
+
+int bandFor(double increment) {
+  int exponent;
+  // increment = m * 2^exponent with m in [0.5, 1); band b covers
+  // (2^b, 2^(b+1)] / TABLE_SIZE.
+  std::frexp(increment * TABLE_SIZE, &exponent);
+  return std::clamp(exponent - 1, 0, BANDS - 1);
+}
+
+int harmonicsFor(int band) {
+  return static_cast<int>(TABLE_SIZE >> (band + 2));
+}
+} // namespace wavetable
+
+BlockKernel wavetableKernel(Waveform waveform) {
+  wavetable::g_bank = &wavetable::bank();
+  switch (waveform) {
+  case Waveform::Square:
+    return wavetable::renderTable<Waveform::Square>;
+  case Waveform::Sawtooth:
+    return wavetable::renderTable<Waveform::Sawtooth>;
+  case Waveform::Triangle:
+    return wavetable::renderTable<Waveform::Triangle>;
+  case Waveform::Sine:
+  default:
+    return wavetable::renderTable<Waveform::Sine>;
+  }
+}
+} // namespace osc
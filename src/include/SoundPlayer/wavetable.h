@@ -0,0 +1,28 @@
+#pragma once
+
+#include "oscillator.h"
+
+#include <cstddef>
+
+// Band-limited wavetable oscillators. Each waveform gets one table per
+// octave band, summed from only the harmonics that stay below Nyquist for
+// the highest fundamental in that band, so high notes do not alias. Playback
+// is a linearly interpolated lookup; the band is chosen once per block from
+// the phase increment.
+namespace osc {
+namespace wavetable {
+constexpr std::size_t TABLE_SIZE = 2048; // samples per cycle, power of two
+// Band b serves increments up to 2^(b+1) / TABLE_SIZE cycles per sample; the
+// last band tops out at Nyquist and holds a pure sine.
+constexpr int BANDS = 10;
+
+// Band index for a phase increment in cycles per sample.
+int bandFor(double increment);
+// Number of harmonics stored in band b.
+int harmonicsFor(int band);
+} // namespace wavetable
+
+// Builds the tables on first use (about 1 MB of float math, a few ms), so
+// call it outside the audio callback.
+BlockKernel wavetableKernel(Waveform waveform);
+} // namespace osc
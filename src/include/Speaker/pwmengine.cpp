@@ -0,0 +1,263 @@
+#include "pwmengine.h"
+
+#include "../Scheduler/scheduler.h"
+#include "../SoundPlayer/wavetable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <pthread.h>
+#include <sched.h>
+#include <stdexcept>
+#include <time.h>
+#include <unistd.h>
+#include <utility>
+
+namespace {
+// Sleep until this close to a deadline, then spin.
+constexpr int64_t SLEEP_MARGIN_NS = 200000;
+// Longest single sleep, so stop() is noticed during long rests.
+constexpr int64_t MAX_SLEEP_NS = 10000000;
+// 2^(0.1 / 1200) - 1: a tenth of a cent.
+constexpr double TENTH_CENT = 5.78e-5;
+
+} // namespace
+
+PwmEngine::DutyTable PwmEngine::dutyTable(double frequency, unsigned rate,
+                                          osc::Waveform waveform,
+                                          osc::Engine engine) {
+  if (frequency <= 0.0 || 2.0 * frequency >= rate)
+    throw std::invalid_argument("PWM cannot play this frequency");
+  const double ratio = frequency / rate;
+  std::size_t periods = 1;
+  double cycles = 0.0;
+  double bestError = std::numeric_limits<double>::infinity();
+  for (std::size_t n = 1; n <= DutyTable::MAX_TABLE; ++n) {
+    const double k = std::round(n * ratio);
+    if (k < 1.0)
+      continue;
+    const double error = std::abs(k / (n * ratio) - 1.0);
+    if (error < bestError) {
+      bestError = error;
+      periods = n;
+      cycles = k;
+    }
+    if (error < TENTH_CENT)
+      break;
+  }
+
+  std::vector<float> samples(periods);
+  double phase = 0.0;
+  const osc::BlockKernel kernel = engine == osc::Engine::Wavetable
+                                      ? osc::wavetableKernel(waveform)
+                                      : osc::kernelFor(waveform, osc::Isa::Scalar);
+  kernel(samples.data(), periods, phase, cycles / periods);
+
+  DutyTable table;
+  table.cycles = static_cast<uint32_t>(cycles);
+  table.onNs.reserve(periods);
+  const int64_t periodNs = 1000000000LL / rate;
+  for (const float sample : samples) {
+    const double duty = std::clamp((sample + 1.0) / 2.0, 0.0, 1.0);
+    int64_t onNs = std::llround(duty * periodNs);
+    if (onNs < MIN_PULSE_NS)
+      onNs = 0;
+    else if (periodNs - onNs < MIN_PULSE_NS)
+      onNs = periodNs;
+    table.onNs.push_back(static_cast<uint32_t>(onNs));
+  }
+  return table;
+}
+
+PwmEngine::PwmEngine(Speaker &speaker, unsigned rate, osc::Waveform waveform,
+                     osc::Engine engine)
+    : speaker_(speaker), rate_(rate), waveform_(waveform), engine_(engine) {
+  if (rate_ == 0 || rate_ > 100000)
+    throw std::invalid_argument("PWM rate must be between 1 Hz and 100 kHz");
+  periodNs_ = 1000000000LL / rate_;
+}
+
+PwmEngine::~PwmEngine() { stop(); }
+
+void PwmEngine::load(std::vector<ToneChange> timeline) {
+  timeline_ = std::move(timeline);
+  tables_.clear();
+  // A square wave is what the speaker plays by itself, and a note above
+  // half the PWM rate cannot be modulated, so both are sent as plain tones.
+  if (waveform_ != osc::Waveform::Square) {
+    for (const ToneChange &change : timeline_)
+      if (change.frequency > 0 && 2u * change.frequency < rate_ &&
+          !tables_.contains(change.frequency))
+        tables_.emplace(change.frequency,
+                        dutyTable(change.frequency, rate_, waveform_, engine_));
+  }
+}
+
+void PwmEngine::start(int64_t originNs) {
+  originNs_ = originNs;
+  tone_ = 0;
+  edges_ = 0;
+  periods_ = 0;
+  skipped_ = 0;
+  maxLateNs_ = 0;
+  late_.fill(0);
+  error_.clear();
+  stopping_.store(false, std::memory_order_relaxed);
+  thread_ = std::thread(&PwmEngine::run, this);
+}
+
+void PwmEngine::join() {
+  if (thread_.joinable())
+    thread_.join();
+  if (!error_.empty())
+    throw std::runtime_error(error_);
+}
+
+void PwmEngine::stop() {
+  if (!thread_.joinable())
+    return;
+  stopping_.store(true, std::memory_order_relaxed);
+  thread_.join();
+  speaker_.stop();
+}
+
+void PwmEngine::run() {
+  // Pinning keeps the spinning thread's cache and timer warm. SCHED_FIFO
+  // would starve everything else on a single CPU, so it is only requested
+  // when another CPU is left for the screen and the main loop.
+  const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  if (cpus > 0) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(static_cast<int>(cpus - 1), &set);
+    pinned_ = pthread_setaffinity_np(pthread_self(), sizeof set, &set) == 0;
+  }
+  if (cpus > 1) {
+    sched_param param{};
+    param.sched_priority = sched_get_priority_max(SCHED_FIFO) / 2;
+    realtime_ = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+  }
+  try {
+    play();
+  } catch (const std::exception &e) {
+    error_ = e.what(); // reported by join()
+  }
+}
+
+void PwmEngine::play() {
+  for (std::size_t i = 0; i < timeline_.size(); ++i) {
+    const ToneChange &change = timeline_[i];
+    const int64_t startNs = originNs_ + static_cast<int64_t>(change.atUs) * 1000;
+    if (!waitUntil(startNs))
+      return;
+    const auto table = tables_.find(change.frequency);
+    if (table == tables_.end()) {
+      setTone(change.frequency, startNs);
+      continue;
+    }
+    // The timeline always ends in silence, so a note has a next change.
+    const int64_t endNs =
+        originNs_ + static_cast<int64_t>(timeline_[i + 1].atUs) * 1000;
+    playNote(table->second, startNs, endNs);
+  }
+}
+
+void PwmEngine::playNote(const DutyTable &table, int64_t startNs,
+                         int64_t endNs) {
+  const std::size_t size = table.onNs.size();
+  uint64_t period = 0;
+  for (;;) {
+    const int64_t periodNs = periodStartNs(startNs, period);
+    if (periodNs >= endNs)
+      return;
+    // After a stall, drop the periods that have already gone by instead of
+    // playing them late; the table index follows, so the pitch holds.
+    const int64_t now = Scheduler::nowNs();
+    if (now > periodNs + periodNs_) {
+      const uint64_t current =
+          static_cast<uint64_t>(now - startNs) * rate_ / 1000000000ULL;
+      skipped_ += current - period;
+      period = current;
+      continue;
+    }
+    const int64_t onNs = table.onNs[period % size];
+    if (onNs > 0) {
+      if (!waitUntil(periodNs))
+        return;
+      setTone(CARRIER_HZ, periodNs);
+    }
+    const int64_t offNs = periodNs + onNs;
+    if (onNs < periodNs_ && offNs < endNs) {
+      if (!waitUntil(offNs))
+        return;
+      setTone(0, offNs);
+    }
+    ++periods_;
+    ++period;
+  }
+}
+
+void PwmEngine::setTone(int frequency, int64_t deadlineNs) {
+  if (frequency == tone_)
+    return;
+  speaker_.sendTone(frequency);
+  tone_ = frequency;
+  ++edges_;
+  const int64_t lateNs = std::max<int64_t>(Scheduler::nowNs() - deadlineNs, 0);
+  maxLateNs_ = std::max(maxLateNs_, lateNs);
+  ++late_[std::min<std::size_t>(lateNs / 1000, LATE_BUCKETS - 1)];
+}
+
+bool PwmEngine::waitUntil(int64_t deadlineNs) const {
+  for (;;) {
+    if (stopping_.load(std::memory_order_relaxed))
+      return false;
+    const int64_t leftNs = deadlineNs - Scheduler::nowNs();
+    if (leftNs <= 0)
+      return true;
+    if (leftNs > SLEEP_MARGIN_NS) {
+      const int64_t sleepNs = std::min(leftNs - SLEEP_MARGIN_NS, MAX_SLEEP_NS);
+      const timespec ts{static_cast<time_t>(sleepNs / 1000000000LL),
+                        static_cast<long>(sleepNs % 1000000000LL)};
+      nanosleep(&ts, nullptr);
+    }
+  }
+}
+
+PwmEngine::Report PwmEngine::report() const {
+  Report report{};
+  report.edges = edges_;
+  report.periods = periods_;
+  report.skipped = skipped_;
+  report.maxLateNs = maxLateNs_;
+  report.realtime = realtime_;
+  report.pinned = pinned_;
+  // Each percentile is reported as the upper edge of its bucket.
+  auto percentile = [&](double fraction) -> int64_t {
+    const uint64_t target = static_cast<uint64_t>(std::ceil(edges_ * fraction));
+    uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < LATE_BUCKETS - 1; ++bucket) {
+      seen += late_[bucket];
+      if (seen >= target)
+        return std::min<int64_t>((bucket + 1) * 1000, maxLateNs_);
+    }
+    return maxLateNs_;
+  };
+  if (edges_ > 0) {
+    report.p50LateNs = percentile(0.50);
+    report.p99LateNs = percentile(0.99);
+  }
+  return report;
+}
+
+void PwmEngine::printReport(std::ostream &out) const {
+  const Report r = report();
+  out << "PWM engine: " << rate_ << " Hz, " << r.periods << " periods in "
+      << r.edges << " speaker writes, " << r.skipped << " periods skipped\n";
+  out << "  write lateness: p50 " << r.p50LateNs / 1e3 << " us, p99 "
+      << r.p99LateNs / 1e3 << " us, max " << r.maxLateNs / 1e3 << " us\n";
+  if (!r.realtime || !r.pinned)
+    out << "  running without " << (r.realtime ? "" : "SCHED_FIFO")
+        << (!r.realtime && !r.pinned ? " or " : "")
+        << (r.pinned ? "" : "CPU pinning") << "\n";
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "../SoundPlayer/oscillator.h"
+#include "speaker.h"
+#include "speakerengine.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Plays waveforms other than a square wave on the pc speaker by pulse-width
+// modulation: the speaker is switched on and off `rate` times a second, and
+// the share of each period it stays on follows the waveform. "On" is a tone
+// above hearing, which the cone cannot follow and averages out.
+//
+// Each note gets a precomputed table of on-times, one per PWM period, so the
+// playback thread only steps an index and busy-waits for absolute deadlines.
+// The thread is pinned to the last CPU and asks for SCHED_FIFO when there is
+// another CPU left for the rest of the program.
+class PwmEngine {
+public:
+  // Highest tone the pcspkr driver accepts; used as the "on" level.
+  static constexpr int CARRIER_HZ = 32766;
+  static constexpr unsigned DEFAULT_RATE = 20000;
+  // Pulses shorter than this cannot be told apart from the cost of the
+  // write that ends them, so duties that close to 0 or 1 are rounded off.
+  static constexpr int64_t MIN_PULSE_NS = 2000;
+  // Lateness histogram: 1 us buckets, the last one open-ended.
+  static constexpr std::size_t LATE_BUCKETS = 256;
+
+  struct Report {
+    uint64_t edges;   // speaker writes
+    uint64_t periods; // PWM periods played
+    uint64_t skipped; // periods dropped to catch up after a stall
+    int64_t p50LateNs;
+    int64_t p99LateNs;
+    int64_t maxLateNs;
+    bool realtime; // got SCHED_FIFO
+    bool pinned;   // got the CPU affinity
+  };
+
+  // One table per distinct frequency: `periods` on-times that together play
+  // `cycles` whole cycles of the waveform, chosen so that cycles / periods
+  // matches the pitch to within a tenth of a cent where a table of at most
+  // MAX_TABLE periods allows it.
+  struct DutyTable {
+    static constexpr std::size_t MAX_TABLE = 4096;
+    std::vector<uint32_t> onNs;
+    uint32_t cycles;
+  };
+  static DutyTable dutyTable(double frequency, unsigned rate,
+                             osc::Waveform waveform, osc::Engine engine);
+
+  // Throws std::invalid_argument if `rate` is 0 or above 100 kHz.
+  PwmEngine(Speaker &speaker, unsigned rate, osc::Waveform waveform,
+            osc::Engine engine);
+  ~PwmEngine();
+  PwmEngine(const PwmEngine &) = delete;
+  PwmEngine &operator=(const PwmEngine &) = delete;
+
+  // Builds the duty tables for every pitch in `timeline`, which can take a
+  // few milliseconds, so call it before the song's clock starts.
+  void load(std::vector<ToneChange> timeline);
+  // Plays the loaded timeline; `originNs` is the CLOCK_MONOTONIC time of
+  // offset 0.
+  void start(int64_t originNs);
+  // Waits until the timeline has been played. Throws std::runtime_error if
+  // writing to the speaker failed.
+  void join();
+  // Silences the speaker and abandons the rest of the timeline.
+  void stop();
+
+  // Valid once join() or stop() has returned.
+  Report report() const;
+  void printReport(std::ostream &out) const;
+
+private:
+  void run();
+  void play();
+  void playNote(const DutyTable &table, int64_t startNs, int64_t endNs);
+  // Writes `frequency` unless the speaker already plays it.
+  void setTone(int frequency, int64_t deadlineNs);
+  bool waitUntil(int64_t deadlineNs) const;
+  int64_t periodStartNs(int64_t startNs, uint64_t period) const {
+    return startNs + static_cast<int64_t>(period * 1000000000ULL / rate_);
+  }
+
+  Speaker &speaker_;
+  unsigned rate_;
+  int64_t periodNs_;
+  osc::Waveform waveform_;
+  osc::Engine engine_;
+  std::vector<ToneChange> timeline_;
+  std::map<int, DutyTable> tables_;
+  int64_t originNs_ = 0;
+  int tone_ = 0; // last frequency written
+  uint64_t edges_ = 0;
+  uint64_t periods_ = 0;
+  uint64_t skipped_ = 0;
+  int64_t maxLateNs_ = 0;
+  std::array<uint64_t, LATE_BUCKETS> late_{};
+  bool realtime_ = false;
+  bool pinned_ = false;
+  std::string error_;
+  std::atomic<bool> stopping_{false};
+  std::thread thread_;
+};
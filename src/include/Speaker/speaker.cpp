@@ -4,19 +4,15 @@
 #include <linux/kd.h>
 #include <stdexcept>
 #include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 
-Speaker::Speaker() : fd_(-1) {
-  fd_ = open("/dev/input/by-path/platform-pcspkr-event-spkr", O_WRONLY);
+Speaker::Speaker(const std::string &device) : fd_(-1) {
+  const int flags = device == DEVICE ? O_WRONLY : O_WRONLY | O_CREAT | O_TRUNC;
+  fd_ = open(device.c_str(), flags, 0644);
   if (fd_ == -1) {
-    throw std::runtime_error("Failed to open speaker device");
+    throw std::runtime_error("Failed to open speaker device " + device);
   }
-
-  gettimeofday(&tv_, nullptr);
-  ev_.t_val = tv_;
-  ev_.type = EV_SND;
-  ev_.code = SND_TONE;
-  ev_.value = 0;
 }
 
 Speaker::~Speaker() {
@@ -27,9 +23,22 @@ Speaker::~Speaker() {
   }
 }
 
-void Speaker::sendTone(int tone) {
-  ev_.value = tone;
-  ssize_t result = write(fd_, &ev_, sizeof(ev_));
+void Speaker::sendTone(int tone) { sendTones(&tone, 1); }
+
+void Speaker::sendTones(const int *tones, std::size_t count) {
+  if (count > MAX_BATCH)
+    throw std::runtime_error("Too many tones in one batch");
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  EventVal events[MAX_BATCH];
+  for (std::size_t i = 0; i < count; ++i) {
+    events[i].t_val.tv_sec = now.tv_sec;
+    events[i].t_val.tv_usec = now.tv_nsec / 1000;
+    events[i].type = EV_SND;
+    events[i].code = SND_TONE;
+    events[i].value = static_cast<uint32_t>(tones[i]);
+  }
+  ssize_t result = write(fd_, events, count * sizeof(EventVal));
   if (result == -1) {
     throw std::runtime_error("Failed to send tone");
   }
@@ -1,23 +1,38 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
+#include <sys/time.h>
 
 class Speaker {
 public:
-    Speaker();
+    static constexpr const char *DEVICE =
+        "/dev/input/by-path/platform-pcspkr-event-spkr";
+
+    // Any other path receives the same input_event records, so a file or a
+    // FIFO can record what would have been played; files are created.
+    explicit Speaker(const std::string &device = DEVICE);
     ~Speaker();
 
+    // Largest batch sendTones() writes at once.
+    static constexpr std::size_t MAX_BATCH = 16;
+
+    // Each event is stamped with the CLOCK_MONOTONIC time it was written at,
+    // so a recording shows when every change actually went out.
     void sendTone(int tone);
+    // Writes up to MAX_BATCH tone changes with a single write(); only the
+    // last one is heard, but a recording keeps them all.
+    void sendTones(const int *tones, std::size_t count);
     void stop();
 
-private:
-    int fd_;
-    struct timeval tv_;
     struct EventVal {
         struct timeval t_val;
         uint16_t type;
         uint16_t code;
         uint32_t value;
-    } ev_;
+    };
+
+private:
+    int fd_;
 };
@@ -0,0 +1,234 @@
+#include "speakerengine.h"
+#include "../Scheduler/scheduler.h"
+
+#include <algorithm>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+std::vector<ToneChange> toneTimeline(EventSource &song, uint64_t *songEndUs) {
+  std::vector<ToneChange> timeline;
+  uint64_t onsetUs = 0;
+  uint64_t endUs = 0;
+  uint64_t soundingEndUs = 0;
+  bool sounding = false;
+  SongEvent event;
+  while (song.next(event)) {
+    onsetUs += event.delayUs;
+    if (sounding && soundingEndUs < onsetUs) {
+      timeline.push_back({soundingEndUs, 0});
+      sounding = false;
+    }
+    endUs = std::max(endUs, onsetUs + event.durationUs);
+    if (event.kind == SongEvent::Kind::Note) {
+      timeline.push_back({onsetUs, static_cast<int>(event.frequency)});
+      sounding = true;
+      soundingEndUs = onsetUs + event.durationUs;
+    } else if (sounding && soundingEndUs <= onsetUs) {
+      timeline.push_back({onsetUs, 0});
+      sounding = false;
+    }
+  }
+  if (sounding)
+    timeline.push_back({soundingEndUs, 0});
+  if (songEndUs)
+    *songEndUs = endUs;
+  return timeline;
+}
+
+std::vector<ToneChange> arpeggioTimeline(EventSource &song, double rateHz,
+                                         uint64_t *songEndUs) {
+  if (!(rateHz > 0.0))
+    throw std::invalid_argument("Arpeggio rate must be positive");
+  struct Held {
+    uint64_t endUs;
+    int frequency;
+  };
+  std::vector<Held> notes; // in onset order, with their start times below
+  std::vector<uint64_t> startsUs;
+  uint64_t onsetUs = 0;
+  uint64_t endUs = 0;
+  SongEvent event;
+  while (song.next(event)) {
+    onsetUs += event.delayUs;
+    endUs = std::max(endUs, onsetUs + event.durationUs);
+    if (event.kind == SongEvent::Kind::Note && event.durationUs > 0) {
+      notes.push_back({onsetUs + event.durationUs,
+                       static_cast<int>(event.frequency)});
+      startsUs.push_back(onsetUs);
+    }
+  }
+  if (songEndUs)
+    *songEndUs = endUs;
+
+  std::vector<ToneChange> timeline;
+  int current = 0;
+  auto change = [&](uint64_t atUs, int frequency) {
+    if (frequency == current)
+      return;
+    if (!timeline.empty() && timeline.back().atUs == atUs)
+      timeline.back().frequency = frequency;
+    else
+      timeline.push_back({atUs, frequency});
+    current = frequency;
+  };
+
+  // Between consecutive note starts and ends the set of held notes is
+  // fixed; each such span is played as its own run of steps.
+  const double stepUs = 1e6 / rateHz;
+  std::vector<Held> held;
+  std::vector<int> chord;
+  std::size_t next = 0;
+  uint64_t nowUs = 0;
+  while (next < notes.size() || !held.empty()) {
+    uint64_t untilUs = next < notes.size() ? startsUs[next] : UINT64_MAX;
+    for (const Held &note : held)
+      untilUs = std::min(untilUs, note.endUs);
+    if (untilUs > nowUs) {
+      chord.clear();
+      for (const Held &note : held)
+        chord.push_back(note.frequency);
+      std::sort(chord.begin(), chord.end());
+      chord.erase(std::unique(chord.begin(), chord.end()), chord.end());
+      if (chord.size() <= 1) {
+        change(nowUs, chord.empty() ? 0 : chord.front());
+      } else {
+        for (std::size_t step = 0;; ++step) {
+          const uint64_t atUs = nowUs + static_cast<uint64_t>(step * stepUs);
+          if (atUs >= untilUs)
+            break;
+          change(atUs, chord[step % chord.size()]);
+        }
+      }
+    }
+    nowUs = untilUs;
+    std::erase_if(held, [&](const Held &note) { return note.endUs <= nowUs; });
+    while (next < notes.size() && startsUs[next] <= nowUs)
+      held.push_back(notes[next++]);
+  }
+  change(nowUs, 0);
+  return timeline;
+}
+
+SpeakerEngine::SpeakerEngine(Speaker &speaker)
+    : speaker_(speaker),
+      timerFd_(timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC)),
+      wakeFd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {
+  if (timerFd_ == -1 || wakeFd_ == -1) {
+    if (timerFd_ != -1)
+      close(timerFd_);
+    if (wakeFd_ != -1)
+      close(wakeFd_);
+    throw std::runtime_error("Failed to create the speaker timer");
+  }
+}
+
+SpeakerEngine::~SpeakerEngine() {
+  stop();
+  close(timerFd_);
+  close(wakeFd_);
+}
+
+void SpeakerEngine::start(std::vector<ToneChange> timeline, int64_t originNs) {
+  timeline_ = std::move(timeline);
+  lateNs_.assign(timeline_.size(), 0);
+  originNs_ = originNs;
+  played_ = 0;
+  writes_ = 0;
+  error_.clear();
+  stopping_.store(false, std::memory_order_relaxed);
+  thread_ = std::thread(&SpeakerEngine::run, this);
+}
+
+void SpeakerEngine::join() {
+  if (thread_.joinable())
+    thread_.join();
+  if (!error_.empty())
+    throw std::runtime_error(error_);
+}
+
+void SpeakerEngine::stop() {
+  if (!thread_.joinable())
+    return;
+  stopping_.store(true, std::memory_order_relaxed);
+  const uint64_t one = 1;
+  const ssize_t ignored = write(wakeFd_, &one, sizeof one);
+  (void)ignored; // an eventfd write cannot fail short of overflow
+  thread_.join();
+  uint64_t drained;
+  const ssize_t cleared = read(wakeFd_, &drained, sizeof drained);
+  (void)cleared; // resets the eventfd for the next start()
+  speaker_.stop();
+}
+
+void SpeakerEngine::armTimer(int64_t deadlineNs) {
+  itimerspec spec{};
+  spec.it_value.tv_sec = deadlineNs / 1000000000LL;
+  spec.it_value.tv_nsec = deadlineNs % 1000000000LL;
+  timerfd_settime(timerFd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+void SpeakerEngine::run() {
+  try {
+    play();
+  } catch (const std::exception &e) {
+    error_ = e.what(); // reported by join()
+  }
+}
+
+void SpeakerEngine::play() {
+  pollfd fds[2] = {{timerFd_, POLLIN, 0}, {wakeFd_, POLLIN, 0}};
+  std::size_t next = 0;
+  while (next < timeline_.size()) {
+    armTimer(deadlineNs(next));
+    if (poll(fds, 2, -1) == -1)
+      continue; // EINTR: wait for the same deadline again
+    if (stopping_.load(std::memory_order_relaxed))
+      return;
+    uint64_t expirations;
+    if (read(timerFd_, &expirations, sizeof expirations) == -1)
+      continue;
+
+    // Everything that is due by now goes out in the same write.
+    int tones[Speaker::MAX_BATCH];
+    std::size_t count = 0;
+    const int64_t wokeNs = Scheduler::nowNs();
+    const std::size_t first = next;
+    while (next < timeline_.size() && count < Speaker::MAX_BATCH &&
+           deadlineNs(next) <= wokeNs)
+      tones[count++] = timeline_[next++].frequency;
+    if (count == 0)
+      continue;
+    speaker_.sendTones(tones, count);
+    ++writes_;
+    const int64_t writtenNs = Scheduler::nowNs();
+    for (std::size_t i = first; i < next; ++i)
+      lateNs_[i] = writtenNs - deadlineNs(i);
+    played_ = next;
+  }
+}
+
+SpeakerEngine::Report SpeakerEngine::report() const {
+  Report report{};
+  std::vector<int64_t> late(lateNs_.begin(), lateNs_.begin() + played_);
+  report.changes = late.size();
+  report.writes = writes_;
+  if (late.empty())
+    return report;
+  std::sort(late.begin(), late.end());
+  report.p50LateNs = late[(late.size() - 1) / 2];
+  report.p99LateNs = late[(late.size() - 1) * 99 / 100];
+  report.maxLateNs = late.back();
+  return report;
+}
+
+void SpeakerEngine::printReport(std::ostream &out) const {
+  const Report r = report();
+  out << "Speaker engine: " << r.changes << " tone changes in " << r.writes
+      << " writes\n";
+  out << "  write lateness: p50 " << r.p50LateNs / 1e3 << " us, p99 "
+      << r.p99LateNs / 1e3 << " us, max " << r.maxLateNs / 1e3 << " us\n";
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "../Song/eventsource.h"
+#include "speaker.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A change of the speaker's pitch at an offset from the start of the song;
+// frequency 0 silences it.
+struct ToneChange {
+  uint64_t atUs;
+  int frequency;
+};
+
+// Every tone change the buzzer makes over a whole song: the latest note to
+// start wins, and the output is silenced when that note ends before the
+// next onset. `songEndUs`, if given, receives the end of the last event.
+std::vector<ToneChange> toneTimeline(EventSource &song,
+                                     uint64_t *songEndUs = nullptr);
+
+// Like toneTimeline(), but where notes overlap the buzzer cycles through
+// them from lowest to highest, one step of 1 / `rateHz` seconds each, the
+// way trackers fake chords on a single voice. Steps restart from the lowest
+// note whenever a note starts or ends.
+std::vector<ToneChange> arpeggioTimeline(EventSource &song, double rateHz,
+                                         uint64_t *songEndUs = nullptr);
+
+// Plays a precomputed tone timeline on its own thread. Each change is due
+// at an absolute CLOCK_MONOTONIC deadline armed on a timerfd, so nothing
+// accumulates from one note to the next; changes that are due by the time
+// the thread wakes go out together in one write().
+class SpeakerEngine {
+public:
+  struct Report {
+    uint64_t changes;
+    uint64_t writes;
+    int64_t p50LateNs;
+    int64_t p99LateNs;
+    int64_t maxLateNs;
+  };
+
+  // Throws std::runtime_error if the timer cannot be created.
+  explicit SpeakerEngine(Speaker &speaker);
+  ~SpeakerEngine();
+  SpeakerEngine(const SpeakerEngine &) = delete;
+  SpeakerEngine &operator=(const SpeakerEngine &) = delete;
+
+  // `originNs` is the CLOCK_MONOTONIC time of offset 0.
+  void start(std::vector<ToneChange> timeline, int64_t originNs);
+  // Waits until every change has been written. Throws std::runtime_error
+  // if writing to the speaker failed.
+  void join();
+  // Silences the speaker and abandons the rest of the timeline.
+  void stop();
+
+  // Valid once join() or stop() has returned.
+  Report report() const;
+  void printReport(std::ostream &out) const;
+
+private:
+  void run();
+  void play();
+  void armTimer(int64_t deadlineNs);
+  int64_t deadlineNs(std::size_t change) const {
+    return originNs_ + static_cast<int64_t>(timeline_[change].atUs) * 1000;
+  }
+
+  Speaker &speaker_;
+  int timerFd_;
+  int wakeFd_; // an eventfd that stop() signals
+  std::vector<ToneChange> timeline_;
+  std::vector<int64_t> lateNs_; // sized up front; filled by the thread
+  int64_t originNs_ = 0;
+  std::size_t played_ = 0;
+  uint64_t writes_ = 0;
+  std::string error_;
+  std::atomic<bool> stopping_{false};
+  std::thread thread_;
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+// Bounded single-producer/single-consumer queue. Neither side ever blocks or
+// allocates: push fails when the ring is full and pop fails when it is empty,
+// and the caller decides what to do about it.
+template <typename T, std::size_t Capacity> class SpscRing {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                "SpscRing capacity must be a power of two");
+  static_assert(std::is_trivially_copyable_v<T>,
+                "SpscRing elements are copied between threads");
+
+public:
+  bool push(const T &item) {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tailCache_ == Capacity) {
+      tailCache_ = tail_.load(std::memory_order_acquire);
+      if (head - tailCache_ == Capacity)
+        return false;
+    }
+    slots_[head & MASK] = item;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(T &item) {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == headCache_) {
+      headCache_ = head_.load(std::memory_order_acquire);
+      if (tail == headCache_)
+        return false;
+    }
+    item = slots_[tail & MASK];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Approximate when called concurrently with the other side.
+  std::size_t size() const {
+    return head_.load(std::memory_order_acquire) -
+           tail_.load(std::memory_order_acquire);
+  }
+  bool empty() const { return size() == 0; }
+  static constexpr std::size_t capacity() { return Capacity; }
+
+private:
+  static constexpr std::size_t MASK = Capacity - 1;
+  static constexpr std::size_t CACHE_LINE = 64;
+
+  // Producer and consumer state live on separate cache lines so the two
+  // threads do not keep invalidating each other.
+  alignas(CACHE_LINE) std::atomic<std::size_t> head_{0};
+  std::size_t tailCache_ = 0;
+  alignas(CACHE_LINE) std::atomic<std::size_t> tail_{0};
+  std::size_t headCache_ = 0;
+  alignas(CACHE_LINE) std::array<T, Capacity> slots_{};
+};
@@ -0,0 +1,111 @@
+#include "callbacktelemetry.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+
+CallbackTelemetry::CallbackTelemetry(double sampleRate)
+    : sampleRate_(sampleRate) {}
+
+void CallbackTelemetry::record(unsigned long frames, int64_t durationNs,
+                               bool underflow) {
+  // Single writer: plain load-then-store is enough for every field.
+  auto bump = [](std::atomic<uint64_t> &counter, uint64_t by) {
+    counter.store(counter.load(std::memory_order_relaxed) + by,
+                  std::memory_order_relaxed);
+  };
+  const double periodNs = frames * 1e9 / sampleRate_;
+  bump(callbacks_, 1);
+  bump(frames_, frames);
+  if (underflow)
+    bump(underflows_, 1);
+  if (durationNs > periodNs)
+    bump(overruns_, 1);
+  bump(buckets_[bucketFor(durationNs)], 1);
+  lastFrames_.store(frames, std::memory_order_relaxed);
+  if (durationNs > maxNs_.load(std::memory_order_relaxed))
+    maxNs_.store(durationNs, std::memory_order_relaxed);
+  const double load = frames != 0 ? durationNs / periodNs : 0.0;
+  if (load > maxLoad_.load(std::memory_order_relaxed))
+    maxLoad_.store(load, std::memory_order_relaxed);
+}
+
+std::size_t CallbackTelemetry::bucketFor(int64_t ns) {
+  if (ns < 4)
+    return static_cast<std::size_t>(std::max<int64_t>(ns, 0));
+  const int octave = std::bit_width(static_cast<uint64_t>(ns)) - 1;
+  const std::size_t step = static_cast<std::size_t>(ns >> (octave - 2)) & 3;
+  return std::min(BUCKETS - 1,
+                  4 * static_cast<std::size_t>(octave - 1) + step);
+}
+
+int64_t CallbackTelemetry::bucketLimit(std::size_t bucket) {
+  if (bucket < 4)
+    return static_cast<int64_t>(bucket) + 1;
+  const int octave = static_cast<int>(bucket / 4) + 1;
+  return static_cast<int64_t>(4 + bucket % 4 + 1) << (octave - 2);
+}
+
+int64_t CallbackTelemetry::percentile(
+    const std::array<uint64_t, BUCKETS> &counts, uint64_t total,
+    double fraction, int64_t maxNs) {
+  const uint64_t rank = static_cast<uint64_t>(fraction * (total - 1));
+  uint64_t seen = 0;
+  for (std::size_t i = 0; i < BUCKETS; ++i) {
+    seen += counts[i];
+    if (seen > rank)
+      return std::min(bucketLimit(i), maxNs);
+  }
+  return maxNs;
+}
+
+CallbackTelemetry::Snapshot CallbackTelemetry::snapshot() const {
+  Snapshot s{};
+  s.callbacks = callbacks_.load(std::memory_order_relaxed);
+  s.frames = frames_.load(std::memory_order_relaxed);
+  s.underflows = underflows_.load(std::memory_order_relaxed);
+  s.overruns = overruns_.load(std::memory_order_relaxed);
+  s.lastFrames = lastFrames_.load(std::memory_order_relaxed);
+  s.maxNs = maxNs_.load(std::memory_order_relaxed);
+  s.maxLoad = maxLoad_.load(std::memory_order_relaxed);
+  s.violations = rtcheck::counts();
+  std::array<uint64_t, BUCKETS> counts;
+  uint64_t total = 0;
+  for (std::size_t i = 0; i < BUCKETS; ++i)
+    total += counts[i] = buckets_[i].load(std::memory_order_relaxed);
+  if (total != 0) {
+    s.p50Ns = percentile(counts, total, 0.50, s.maxNs);
+    s.p99Ns = percentile(counts, total, 0.99, s.maxNs);
+  }
+  return s;
+}
+
+std::string CallbackTelemetry::statusLine() const {
+  const Snapshot s = snapshot();
+  char line[160];
+  int n = std::snprintf(
+      line, sizeof line,
+      "audio: %lu frames/cb, p99 %.1f us, max %.1f%% of buffer, %llu xruns",
+      s.lastFrames, s.p99Ns / 1e3, s.maxLoad * 100.0,
+      static_cast<unsigned long long>(s.underflows + s.overruns));
+  if (rtcheck::ENABLED && n > 0 && static_cast<std::size_t>(n) < sizeof line)
+    std::snprintf(line + n, sizeof line - n, ", %llu allocs, %llu locks",
+                  static_cast<unsigned long long>(s.violations.allocations),
+                  static_cast<unsigned long long>(s.violations.locks));
+  return line;
+}
+
+void CallbackTelemetry::printSummary(std::ostream &out) const {
+  const Snapshot s = snapshot();
+  out << "Audio callbacks: " << s.callbacks << " (" << s.frames
+      << " frames, last buffer " << s.lastFrames << " frames = "
+      << s.lastFrames * 1e3 / sampleRate_ << " ms)\n";
+  out << "  duration: p50 " << s.p50Ns / 1e3 << " us, p99 " << s.p99Ns / 1e3
+      << " us, max " << s.maxNs / 1e3 << " us, worst load "
+      << s.maxLoad * 100.0 << "% of the buffer period\n";
+  out << "  underflows: " << s.underflows << ", callbacks over budget: "
+      << s.overruns << "\n";
+  if (rtcheck::ENABLED)
+    out << "  in callbacks: " << s.violations.allocations
+        << " heap allocations, " << s.violations.locks << " mutex locks\n";
+}
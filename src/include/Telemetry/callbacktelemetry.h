@@ -0,0 +1,60 @@
+#pragma once
+
+#include "rtcheck.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Health of an audio output: how long each callback took against the time
+// its buffer lasts, and how often the output ran dry. The audio thread is
+// the only writer and uses relaxed atomics, so recording never blocks or
+// allocates; any other thread may read a snapshot at any time.
+class CallbackTelemetry {
+public:
+  // Durations go into log-linear buckets: four per power of two, so a
+  // percentile is off by at most a quarter of its value.
+  static constexpr std::size_t BUCKETS = 144;
+
+  struct Snapshot {
+    uint64_t callbacks;
+    uint64_t frames;
+    uint64_t underflows; // buffers the output needed before they were ready
+    uint64_t overruns;   // callbacks that took longer than their buffer
+    unsigned long lastFrames;
+    int64_t p50Ns;
+    int64_t p99Ns;
+    int64_t maxNs;
+    double maxLoad; // worst callback time over its buffer's duration
+    rtcheck::Counts violations; // RT_CHECK builds only
+  };
+
+  explicit CallbackTelemetry(double sampleRate);
+
+  // Audio thread only.
+  void record(unsigned long frames, int64_t durationNs, bool underflow);
+
+  Snapshot snapshot() const;
+  // One short line for the curses status bar.
+  std::string statusLine() const;
+  void printSummary(std::ostream &out) const;
+
+private:
+  static std::size_t bucketFor(int64_t ns);
+  static int64_t bucketLimit(std::size_t bucket);
+  static int64_t percentile(const std::array<uint64_t, BUCKETS> &counts,
+                            uint64_t total, double fraction, int64_t maxNs);
+
+  double sampleRate_;
+  std::atomic<uint64_t> callbacks_{0};
+  std::atomic<uint64_t> frames_{0};
+  std::atomic<uint64_t> underflows_{0};
+  std::atomic<uint64_t> overruns_{0};
+  std::atomic<unsigned long> lastFrames_{0};
+  std::atomic<int64_t> maxNs_{0};
+  std::atomic<double> maxLoad_{0.0};
+  std::array<std::atomic<uint64_t>, BUCKETS> buckets_{};
+};
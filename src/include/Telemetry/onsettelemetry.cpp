@@ -0,0 +1,152 @@
+#include "onsettelemetry.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+// Nearest-rank percentile of an already sorted sample.
+int64_t percentile(const std::vector<int64_t> &sorted, double p) {
+  if (sorted.empty())
+    return 0;
+  const std::size_t rank =
+      static_cast<std::size_t>(p / 100.0 * (sorted.size() - 1) + 0.5);
+  return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+void printJitter(std::ostream &out, const char *label,
+                 std::vector<int64_t> samples) {
+  std::sort(samples.begin(), samples.end());
+  out << "  " << label << " jitter: p50 " << percentile(samples, 50) / 1e3
+      << " us, p99 " << percentile(samples, 99) / 1e3 << " us, max "
+      << (samples.empty() ? 0 : samples.back()) / 1e3 << " us\n";
+}
+} // namespace
+
+OnsetTelemetry::OnsetTelemetry(bool enabled, std::size_t capacity)
+    : enabled_(enabled), capacity_(capacity), heardUpTo_(0), notes_(0),
+      originNs_(0), endLateNs_(0) {
+  if (enabled_) {
+    records_.reserve(capacity_);
+    open_.reserve(MAX_OPEN_NOTES);
+  }
+}
+
+uint64_t OnsetTelemetry::nextReleaseUs() const {
+  if (open_.empty())
+    return UINT64_MAX;
+  int64_t earliestNs = INT64_MAX;
+  for (std::size_t index : open_)
+    earliestNs = std::min(earliestNs, records_[index].scheduledOffNs);
+  return static_cast<uint64_t>(earliestNs - originNs_) / 1000;
+}
+
+void OnsetTelemetry::release(int64_t scheduledNs, int64_t actualNs) {
+  std::erase_if(open_, [&](std::size_t index) {
+    Record &record = records_[index];
+    if (record.scheduledOffNs > scheduledNs)
+      return false;
+    record.actualOffNs = actualNs;
+    return true;
+  });
+}
+
+void OnsetTelemetry::mark(const SongEvent &event, int64_t scheduledNs,
+                          int64_t actualNs) {
+  if (!enabled_)
+    return;
+  release(scheduledNs, actualNs);
+  if (event.kind != SongEvent::Kind::Note)
+    return;
+  ++notes_;
+  if (records_.size() == capacity_ || open_.size() == MAX_OPEN_NOTES)
+    return;
+  records_.push_back({scheduledNs, actualNs,
+                      scheduledNs + int64_t{event.durationUs} * 1000, 0,
+                      event.midi});
+  open_.push_back(records_.size() - 1);
+}
+
+void OnsetTelemetry::schedule(const SongEvent &event, int64_t scheduledOnNs,
+                              int64_t scheduledOffNs) {
+  if (!enabled_ || event.kind != SongEvent::Kind::Note)
+    return;
+  ++notes_;
+  if (records_.size() == capacity_)
+    return;
+  records_.push_back({scheduledOnNs, 0, scheduledOffNs, 0, event.midi});
+}
+
+void OnsetTelemetry::heard(int64_t scheduledOnNs, int64_t actualOnNs,
+                           int64_t actualOffNs) {
+  // Skip the notes scheduled earlier that were never reported.
+  while (heardUpTo_ < records_.size() &&
+         records_[heardUpTo_].scheduledOnNs < scheduledOnNs)
+    ++heardUpTo_;
+  // A note past the capacity has no record.
+  if (heardUpTo_ == records_.size() ||
+      records_[heardUpTo_].scheduledOnNs != scheduledOnNs)
+    return;
+  records_[heardUpTo_].actualOnNs = actualOnNs;
+  records_[heardUpTo_].actualOffNs = actualOffNs;
+  ++heardUpTo_;
+}
+
+void OnsetTelemetry::finish(int64_t scheduledNs, int64_t actualNs) {
+  if (!enabled_)
+    return;
+  endLateNs_ = actualNs - scheduledNs;
+  release(scheduledNs, actualNs);
+}
+
+void OnsetTelemetry::printSummary(std::ostream &out) const {
+  if (!enabled_)
+    return;
+  std::vector<int64_t> onsets;
+  std::vector<int64_t> releases;
+  onsets.reserve(records_.size());
+  releases.reserve(records_.size());
+  for (const Record &record : records_) {
+    if (record.actualOnNs != 0)
+      onsets.push_back(record.actualOnNs - record.scheduledOnNs);
+    if (record.actualOffNs != 0)
+      releases.push_back(record.actualOffNs - record.scheduledOffNs);
+  }
+  out << "Note timing: " << notes_ << " notes";
+  if (notes_ > records_.size())
+    out << " (first " << records_.size() << " recorded)";
+  out << "\n";
+  printJitter(out, "onset", std::move(onsets));
+  printJitter(out, "release", std::move(releases));
+  out << "  total drift: " << endLateNs_ / 1e3 << " us\n";
+}
+
+void OnsetTelemetry::writeCsv(const std::string &path) const {
+  std::ofstream out(path);
+  if (!out.is_open()) {
+    throw std::runtime_error("Failed to create file: " + path);
+  }
+  out << std::fixed << std::setprecision(3);
+  out << "index,midi,scheduled_on_us,actual_on_us,onset_jitter_us,"
+         "scheduled_off_us,actual_off_us,release_jitter_us\n";
+  for (std::size_t i = 0; i < records_.size(); ++i) {
+    const Record &r = records_[i];
+    out << i << ',' << static_cast<int>(r.midi) << ','
+        << (r.scheduledOnNs - originNs_) / 1e3 << ',';
+    if (r.actualOnNs != 0)
+      out << (r.actualOnNs - originNs_) / 1e3 << ','
+          << (r.actualOnNs - r.scheduledOnNs) / 1e3 << ',';
+    else
+      out << ",,";
+    if (r.actualOffNs != 0) {
+      out << (r.scheduledOffNs - originNs_) / 1e3 << ','
+          << (r.actualOffNs - originNs_) / 1e3 << ','
+          << (r.actualOffNs - r.scheduledOffNs) / 1e3;
+    } else {
+      out << ",,";
+    }
+    out << '\n';
+  }
+}
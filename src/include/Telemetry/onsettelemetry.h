@@ -0,0 +1,74 @@
+#pragma once
+
+#include "../Song/song.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Records when each note was meant to start and stop against when the
+// output device call actually returned, or, for outputs that place notes
+// ahead of time, against when the output says they sounded. The buffer is
+// allocated up front,
+// so recording during playback never allocates; notes beyond its capacity
+// are counted but not stored.
+class OnsetTelemetry {
+public:
+  static constexpr std::size_t DEFAULT_CAPACITY = 1 << 16;
+  // Notes tracked at once; more overlapping notes than this go unrecorded.
+  static constexpr std::size_t MAX_OPEN_NOTES = 64;
+
+  struct Record {
+    int64_t scheduledOnNs;
+    int64_t actualOnNs; // 0 until a scheduled note has been heard
+    int64_t scheduledOffNs;
+    int64_t actualOffNs; // 0 until the note has been released
+    uint8_t midi;
+  };
+
+  // A disabled recorder ignores every call, so callers need no branches.
+  explicit OnsetTelemetry(bool enabled,
+                          std::size_t capacity = DEFAULT_CAPACITY);
+
+  // Times are CLOCK_MONOTONIC nanoseconds; `originNs` is the song's start.
+  void start(int64_t originNs) { originNs_ = originNs; }
+
+  // Song time in us at which the earliest open note ends; UINT64_MAX if
+  // none is open, and always when disabled. Waiting for it and calling
+  // release() there times each release against the note's own end.
+  uint64_t nextReleaseUs() const;
+  // Call right after the notes due to end at `scheduledNs` stopped sounding.
+  // Ends every open note that was due to stop by then.
+  void release(int64_t scheduledNs, int64_t actualNs);
+  // Call right after the output was switched to `event`. Ends every note
+  // that was due to stop by now, and opens a record if `event` is a note.
+  void mark(const SongEvent &event, int64_t scheduledNs, int64_t actualNs);
+  // The two steps for outputs that queue notes ahead of time: schedule()
+  // opens a record when a note is queued, and heard() completes the record
+  // scheduled at `scheduledOnNs` once the output reports the note. Notes
+  // are reported in the order they were scheduled; a note never reported
+  // keeps no actual times.
+  void schedule(const SongEvent &event, int64_t scheduledOnNs,
+                int64_t scheduledOffNs);
+  void heard(int64_t scheduledOnNs, int64_t actualOnNs, int64_t actualOffNs);
+  // Call right after the output was silenced at the end of the song; ends
+  // the notes still open there.
+  void finish(int64_t scheduledNs, int64_t actualNs);
+
+  bool enabled() const { return enabled_; }
+  void printSummary(std::ostream &out) const;
+  // Throws std::runtime_error if the file cannot be written.
+  void writeCsv(const std::string &path) const;
+
+private:
+  bool enabled_;
+  std::size_t capacity_;
+  std::vector<Record> records_;
+  std::vector<std::size_t> open_; // indices into records_
+  std::size_t heardUpTo_;         // records_ before it are heard or lost
+  uint64_t notes_;
+  int64_t originNs_;
+  int64_t endLateNs_;
+};
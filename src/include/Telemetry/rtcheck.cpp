@@ -0,0 +1,156 @@
+#include "rtcheck.h"
+
+#ifdef RT_CHECK
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <mutex>
+#include <new>
+#include <pthread.h>
+
+// The malloc family and pthread_mutex_lock interposers and the replacement
+// operator new below see every allocation and lock in the process; they only
+// count the ones made inside a callback.
+namespace {
+thread_local bool t_inCallback = false;
+std::atomic<uint64_t> g_allocations{0};
+std::atomic<uint64_t> g_locks{0};
+
+template <typename Fn> Fn next(const char *name) {
+  return reinterpret_cast<Fn>(dlsym(RTLD_NEXT, name));
+}
+
+void countAllocation() {
+  if (t_inCallback)
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+// The C library's allocator, found once on first use.
+struct Allocator {
+  void *(*malloc)(std::size_t);
+  void *(*calloc)(std::size_t, std::size_t);
+  void *(*realloc)(void *, std::size_t);
+  void (*free)(void *);
+};
+Allocator g_real{};
+std::once_flag g_resolved;
+thread_local bool t_resolving = false;
+
+// dlsym() may allocate while the allocator is being looked up. Those few
+// requests are served from this arena, which is zeroed and never reused.
+alignas(std::max_align_t) char g_arena[4096];
+std::atomic<std::size_t> g_arenaUsed{0};
+
+void *arenaAlloc(std::size_t size) {
+  constexpr std::size_t ALIGN = alignof(std::max_align_t);
+  const std::size_t rounded = (size + ALIGN - 1) / ALIGN * ALIGN;
+  const std::size_t offset = g_arenaUsed.fetch_add(rounded);
+  return offset + rounded <= sizeof(g_arena) ? g_arena + offset : nullptr;
+}
+
+bool inArena(const void *p) {
+  const char *c = static_cast<const char *>(p);
+  return c >= g_arena && c < g_arena + sizeof(g_arena);
+}
+
+const Allocator &real() {
+  std::call_once(g_resolved, [] {
+    t_resolving = true;
+    g_real = {next<decltype(Allocator::malloc)>("malloc"),
+              next<decltype(Allocator::calloc)>("calloc"),
+              next<decltype(Allocator::realloc)>("realloc"),
+              next<decltype(Allocator::free)>("free")};
+    t_resolving = false;
+  });
+  return g_real;
+}
+} // namespace
+
+namespace rtcheck {
+CallbackScope::CallbackScope() { t_inCallback = true; }
+CallbackScope::~CallbackScope() { t_inCallback = false; }
+
+Counts counts() {
+  return {g_allocations.load(std::memory_order_relaxed),
+          g_locks.load(std::memory_order_relaxed)};
+}
+} // namespace rtcheck
+
+extern "C" void *malloc(std::size_t size) {
+  if (t_resolving)
+    return arenaAlloc(size);
+  countAllocation();
+  return real().malloc(size);
+}
+
+extern "C" void *calloc(std::size_t count, std::size_t size) {
+  if (t_resolving)
+    return size != 0 && count > SIZE_MAX / size ? nullptr
+                                                : arenaAlloc(count * size);
+  countAllocation();
+  return real().calloc(count, size);
+}
+
+extern "C" void *realloc(void *p, std::size_t size) {
+  if (t_resolving)
+    return p == nullptr ? arenaAlloc(size) : nullptr;
+  countAllocation();
+  if (!inArena(p))
+    return real().realloc(p, size);
+  // Moves an arena block to the real heap; its size was not kept, so copy
+  // whatever of the arena could belong to it.
+  void *moved = real().malloc(size);
+  if (moved != nullptr)
+    std::memcpy(moved, p,
+                std::min<std::size_t>(size, g_arena + sizeof(g_arena) -
+                                                static_cast<char *>(p)));
+  return moved;
+}
+
+// Only here so that arena blocks are never handed to the real free().
+extern "C" void free(void *p) {
+  if (p == nullptr || inArena(p))
+    return;
+  if (t_resolving)
+    return; // nothing to free it with yet; a few bytes leak once
+  real().free(p);
+}
+
+// Plain operator new is counted by malloc(). Every other form of operator
+// new, and every operator delete, ends up in these two or in free(), so they
+// are enough to see all of them.
+void *operator new(std::size_t size) {
+  if (void *p = std::malloc(size != 0 ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  countAllocation();
+  const std::size_t align = static_cast<std::size_t>(alignment);
+  const std::size_t blocks = ((size != 0 ? size : 1) + align - 1) / align;
+  if (void *p = std::aligned_alloc(align, blocks * align))
+    return p;
+  throw std::bad_alloc();
+}
+
+extern "C" int pthread_mutex_lock(pthread_mutex_t *mutex) {
+  static const auto real =
+      next<int (*)(pthread_mutex_t *)>("pthread_mutex_lock");
+  if (t_inCallback)
+    g_locks.fetch_add(1, std::memory_order_relaxed);
+  return real(mutex);
+}
+
+extern "C" int pthread_mutex_trylock(pthread_mutex_t *mutex) {
+  static const auto real =
+      next<int (*)(pthread_mutex_t *)>("pthread_mutex_trylock");
+  if (t_inCallback)
+    g_locks.fetch_add(1, std::memory_order_relaxed);
+  return real(mutex);
+}
+#endif
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+// Debug check that audio callbacks stay real-time safe. In a build with
+// RT_CHECK defined (make RT_CHECK=1 after make clean), every malloc, calloc,
+// realloc and operator new, and every pthread mutex lock, made on a thread
+// while a CallbackScope is alive there is counted. Other C allocators, such
+// as aligned_alloc and posix_memalign, are only seen through aligned operator
+// new. Otherwise everything here compiles to nothing.
+namespace rtcheck {
+struct Counts {
+  uint64_t allocations;
+  uint64_t locks;
+};
+
+#ifdef RT_CHECK
+constexpr bool ENABLED = true;
+
+class CallbackScope {
+public:
+  CallbackScope();
+  ~CallbackScope();
+  CallbackScope(const CallbackScope &) = delete;
+  CallbackScope &operator=(const CallbackScope &) = delete;
+};
+
+Counts counts();
+#else
+constexpr bool ENABLED = false;
+
+class CallbackScope {
+public:
+  CallbackScope() {}
+  ~CallbackScope() {}
+};
+
+inline Counts counts() { return {0, 0}; }
+#endif
+} // namespace rtcheck
@@ -1,21 +1,29 @@
 #include "include/NcursesDrawer/NcursesDrawer.h"
-#include "include/NotePlayer/noteplayer.h"
+#include "include/NcursesDrawer/NcursesUiThread.h"
+#include "include/Options/options.h"
+#include "include/Pitch/pitch.h"
+#include "include/Scheduler/scheduler.h"
+#include "include/Song/eventsource.h"
+#include "include/Telemetry/onsettelemetry.h"
 #include "include/Speaker/speaker.h"
+#include "include/Speaker/pwmengine.h"
+#include "include/Speaker/speakerengine.h"
+#ifdef EMBEDDED_SCORE_HEADER
+#include "include/Song/embeddedscore.h"
+#include EMBEDDED_SCORE_HEADER
+#endif
 
 #include <algorithm>
-#include <chrono>
-#include <cmath>
 #include <csignal>
+#include <cstdint>
 #include <cstdlib>
 #include <curses.h>
 #include <exception>
-#include <fstream>
 #include <iostream>
 #include <memory>
 #include <string>
-#include <thread>
-
-int getNoteOffset(const std::string &note);
+#include <utility>
+#include <vector>
 
 class NcursesSession {
 public:
@@ -45,87 +53,194 @@ extern "C" void handleSignal(int signum) {
     std::exit(signum);
   }
 }
+
+#ifdef EMBEDDED_SCORE_HEADER
+// Built by 'make player SCORE=<file>': the generated header defines
+// EMBEDDED_SCORE, and a mistake in it fails this very declaration.
+constexpr auto EMBEDDED_SONG =
+    embedded::compile<embedded::eventCount(EMBEDDED_SCORE)>(EMBEDDED_SCORE);
+constexpr const char *SONG_ARGUMENT = "";
+#else
+constexpr const char *SONG_ARGUMENT = " <file_name | ->";
+#endif
 } // namespace
 void printUsage(const char *progName) {
-  std::cerr << "Usage: " << progName
-            << " <file_name> [s(Q)uare / sa(W)tooth / (S)ine / (T)riangle]\n";
+  std::cerr << "Usage: " << progName << SONG_ARGUMENT
+            << " [s(Q)uare / sa(W)tooth / (S)ine / (T)riangle]"
+               " [--tuning=equal|just|<cents file>] [--a4=<Hz>] [--spin=<us>]"
+               " [--stats] [--stats-csv=<file>] [--fps=<n>] [--device=<path>]"
+               " [--timerfd] [--pwm[=<Hz>]] [--arpeggio[=<Hz>]]\n";
 }
 int main(int argc, char **argv) try {
-  if (argc < 2) {
+  PlayerOptions options;
+  try {
+    options = parsePlayerOptions(argc, argv);
+  } catch (const std::invalid_argument &e) {
+    std::cerr << e.what() << "\n";
+    printUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+#ifdef EMBEDDED_SCORE_HEADER
+  // The song is built in, so the waveform is the only positional argument.
+  options.positional.insert(options.positional.begin(), "<embedded>");
+#endif
+  if (options.positional.empty()) {
     printUsage(argv[0]);
     return EXIT_FAILURE;
   }
+  // --timerfd, --pwm and --arpeggio play the song from an engine thread;
+  // --arpeggio uses the timerfd engine unless --pwm is given.
+  const bool engineThread =
+      options.timerfd || options.pwmRate != 0 || options.arpeggioHz > 0.0;
+  if (options.timerfd && options.pwmRate != 0) {
+    std::cerr << "--timerfd and --pwm cannot be combined\n";
+    return EXIT_FAILURE;
+  }
+  if (engineThread && !options.statsCsv.empty()) {
+    std::cerr << "--stats-csv is not available with --timerfd, --pwm or"
+                 " --arpeggio\n";
+    return EXIT_FAILURE;
+  }
 
-  const std::string inputFileName = argv[1];
+  const pitch::Table tuning = pitch::makeTuning(options.tuning, options.a4);
+  std::unique_ptr<EventSource> song;
+#ifdef EMBEDDED_SCORE_HEADER
+  song = std::make_unique<embedded::ArrayEventSource>(EMBEDDED_SONG, tuning);
+#else
+  const std::string inputFileName = options.positional[0];
+  // The engines work out every tone change before playing, which a stream
+  // that may never end cannot allow.
+  if (engineThread && isStreamInput(inputFileName)) {
+    std::cerr << "--timerfd, --pwm and --arpeggio need a score file, not "
+                 "stdin or a FIFO\n";
+    return EXIT_FAILURE;
+  }
+  try {
+    song = openSong(inputFileName, SongCompiler::DEFAULT_SAMPLE_RATE, tuning);
+  } catch (const SongParseError &e) {
+    std::cerr << inputFileName << ":" << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+#endif
   std::signal(SIGINT, handleSignal);
-  auto speaker = std::make_shared<Speaker>();
+  auto speaker = options.device.empty()
+                     ? std::make_shared<Speaker>()
+                     : std::make_shared<Speaker>(options.device);
   g_speakerWeak = speaker;
-  NotePlayer notePlayer; // Adjust constructor logic if needed
-  std::ifstream input{inputFileName};
-  if (!input.is_open()) {
-    std::cerr << "Failed to open input file: " << inputFileName << "\n";
-    return EXIT_FAILURE;
+  // In engine mode every tone change is worked out up front and played by
+  // an engine's own thread; the loop below then only feeds the display.
+  SpeakerEngine engine(*speaker);
+  std::unique_ptr<PwmEngine> pwm;
+  std::vector<ToneChange> tones;
+  if (engineThread) {
+    std::vector<SongEvent> events;
+    SongEvent event;
+    while (song->next(event))
+      events.push_back(event);
+    VectorEventSource source(events);
+    tones = options.arpeggioHz > 0.0
+                ? arpeggioTimeline(source, options.arpeggioHz)
+                : toneTimeline(source);
+    song = std::make_unique<VectorEventSource>(std::move(events));
+  }
+  if (options.pwmRate != 0) {
+    const char wave =
+        options.positional.size() > 1 ? options.positional[1][0] : 'Q';
+    pwm = std::make_unique<PwmEngine>(*speaker, options.pwmRate,
+                                      osc::waveformFromSelection(wave),
+                                      osc::engineFromSelection(wave));
+    pwm->load(std::move(tones));
   }
   NcursesSession ncursesSession;
   NcursesDrawer drawer;
   drawer.init();
-  int middleMIDINote = 60; // Middle C
-  drawer.drawStaff(middleMIDINote);
-  std::string note;
-  std::string value;
-  int octave = 0;
-  int bpm = 100;
-  int noteCounter = 0;
-  while (true) {
-    if (!(input >> note)) {
-      break;
-    }
-
-    if (note == "bpm") {
-      if (!(input >> bpm)) {
-        std::cerr << "Error: expected BPM value after 'bpm' command.\n";
-        break;
-      }
-    } else if (note == "P") {
-      if (!(input >> value)) {
-        std::cerr << "Error: expected duration value after 'P' command.\n";
-        break;
+  NcursesUiThread ui(drawer, 60, options.fps);
+  ui.start();
+  Scheduler scheduler(options.spinUs);
+  OnsetTelemetry telemetry(options.stats && !engineThread);
+  uint64_t eventStartUs = 0;
+  uint64_t songEndUs = 0;
+  // The buzzer sounds one pitch at a time: the latest note to start wins,
+  // and the output is silenced when that note ends before the next onset.
+  uint64_t soundingEndUs = 0;
+  bool sounding = false;
+  SongEvent event;
+  // With --stats, every note that ends before `untilUs` is released at its
+  // own end; the buzzer falls silent there if that note is the one sounding.
+  const auto releaseBefore = [&](uint64_t untilUs) {
+    for (uint64_t releaseUs = telemetry.nextReleaseUs(); releaseUs < untilUs;
+         releaseUs = telemetry.nextReleaseUs()) {
+      scheduler.waitUntil(releaseUs);
+      if (sounding && soundingEndUs <= releaseUs) {
+        speaker->stop();
+        sounding = false;
       }
-      int durationMs = notePlayer.getDuration(value, bpm);
-      std::this_thread::sleep_for(std::chrono::milliseconds(durationMs));
-    } else {
-      if (!(input >> octave >> value)) {
-        std::cerr
-            << "Incorrect note entry: expected <note> <octave> <value>.\n";
-        break;
-      }
-      notePlayer.play(note, octave, value, *speaker, bpm);
-      int noteOffset = getNoteOffset(note);
-      int midiNoteNumber = (octave + 1) * 12 + noteOffset;
-      {
-        int middleY = LINES / 2;
-        int verticalPosition = middleY - (midiNoteNumber - middleMIDINote);
-        if (verticalPosition < 2 || verticalPosition > (LINES - 2)) {
-          middleMIDINote = midiNoteNumber;
-          drawer.drawStaff(middleMIDINote);
-        }
-      }
-      int fractionary = notePlayer.getFractionary(value);
-      int fractionaryStemCount =
-          std::max(0, static_cast<int>(std::log2(fractionary) - 2));
-
-      ++noteCounter;
-      drawer.drawNote(note, octave, value, fractionary, fractionaryStemCount,
-                      middleMIDINote, midiNoteNumber, noteCounter);
+      telemetry.release(scheduler.deadlineNs(releaseUs), Scheduler::nowNs());
     }
-    int ch = getch();
-    if (ch == 'q' || ch == 'Q') {
-      break;
+  };
+  scheduler.start();
+  telemetry.start(scheduler.deadlineNs(0));
+  if (pwm)
+    pwm->start(scheduler.deadlineNs(0));
+  else if (engineThread)
+    engine.start(std::move(tones), scheduler.deadlineNs(0));
+  while (!ui.quitRequested() && song->next(event)) {
+    eventStartUs += event.delayUs;
+    releaseBefore(eventStartUs);
+    if (!engineThread && sounding && soundingEndUs < eventStartUs) {
+      scheduler.waitUntil(soundingEndUs);
+      speaker->stop();
+      sounding = false;
     }
+    scheduler.waitUntil(eventStartUs);
+    const int64_t scheduledNs = scheduler.deadlineNs(eventStartUs);
+    const uint64_t eventEndUs = eventStartUs + event.durationUs;
+    songEndUs = std::max(songEndUs, eventEndUs);
+    if (engineThread) {
+      // The engine has already played it.
+    } else if (event.kind == SongEvent::Kind::Note) {
+      speaker->sendTone(static_cast<int>(event.frequency));
+      sounding = true;
+      soundingEndUs = eventEndUs;
+    } else if (sounding && soundingEndUs <= eventStartUs) {
+      speaker->stop();
+      sounding = false;
+    }
+    telemetry.mark(event, scheduledNs, Scheduler::nowNs());
+    ui.post(event);
+  }
+  if (!ui.quitRequested())
+    releaseBefore(songEndUs);
+  if (pwm) {
+    if (ui.quitRequested())
+      pwm->stop();
+    else
+      pwm->join();
+  } else if (engineThread) {
+    if (ui.quitRequested())
+      engine.stop();
+    else
+      engine.join();
+  } else {
+    if (!ui.quitRequested() && sounding)
+      scheduler.waitUntil(soundingEndUs);
+    speaker->stop();
   }
+  if (!ui.quitRequested())
+    scheduler.waitUntil(songEndUs);
+  telemetry.finish(scheduler.deadlineNs(songEndUs), Scheduler::nowNs());
+  ui.stop();
   drawer.displayIdle();
   drawer.waitForExit();
   drawer.end();
+  scheduler.printReport(std::cerr);
+  telemetry.printSummary(std::cerr);
+  if (engineThread && !pwm && options.stats)
+    engine.printReport(std::cerr);
+  if (pwm && options.stats)
+    pwm->printReport(std::cerr);
+  if (!options.statsCsv.empty())
+    telemetry.writeCsv(options.statsCsv);
 
   return EXIT_SUCCESS;
 } catch (const std::exception &e) {
@@ -1,20 +1,27 @@
 #include "include/NcursesDrawer/NcursesDrawer.h"
-#include "include/NotePlayer/noteplayer_soundcard.h"
+#include "include/NcursesDrawer/NcursesUiThread.h"
+#include "include/Options/options.h"
+#include "include/Pitch/pitch.h"
+#include "include/Render/prerender.h"
+#include "include/Scheduler/scheduler.h"
+#include "include/Song/eventsource.h"
+#include "include/Telemetry/onsettelemetry.h"
 #include "include/SoundPlayer/soundplayer.h"
 
-#include <chrono> // for std::chrono::milliseconds
-#include <cmath>
+#include <algorithm>
+#include <chrono>
 #include <csignal>
+#include <cstdint>
 #include <cstdlib>
-#include <curses.h> // for LINES, getch()
+#include <cstring>
+#include <curses.h> // for endwin()
 #include <exception>
-#include <fstream>
 #include <iostream>
 #include <memory>
 #include <portaudio.h>
 #include <string>
-#include <thread> // for std::this_thread::sleep_for
-int getNoteOffset(const std::string &note);
+#include <utility>
+#include <vector>
 class NcursesSession {
 public:
   NcursesSession() {
@@ -65,86 +72,138 @@ extern "C" void handle_signal(int signum) {
   }
 }
 void printUsage(const char *programName) {
-  std::cerr << "Usage: " << programName << " <file_name>\n";
+  std::cerr << "Usage: " << programName
+            << " <file_name | -> [Q/W/S/T | q/w/s/t]"
+               " [--tuning=equal|just|<cents file>] [--a4=<Hz>] [--spin=<us>]"
+               " [--stats] [--stats-csv=<file>] [--fps=<n>] [--dds]"
+               " [--prerender] [--threads=<n>]"
+               " [--sink=portaudio|null|<file>|-]\n";
 }
 int main(int argc, char **argv) try {
-  if (argc < 2) {
+  PlayerOptions options;
+  try {
+    options = parsePlayerOptions(argc, argv);
+  } catch (const std::invalid_argument &e) {
+    std::cerr << e.what() << "\n";
+    printUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  if (options.positional.empty()) {
     printUsage(argv[0]);
     return EXIT_FAILURE;
   }
   char selection = 'Q'; // default is square wave
-  if (argc >= 3) {
-    if (*argv[2] != 'Q' && *argv[2] != 'W' && *argv[2] != 'S' &&
-        *argv[2] != 'T')
-      std::cout << "Invalid wave selection. Defaulting to square" << std::endl;
+  if (options.positional.size() >= 2) {
+    const char wave = options.positional[1][0];
+    if (wave == '\0' || std::strchr("QWSTqwst", wave) == nullptr)
+      std::cerr << "Invalid wave selection. Defaulting to square" << std::endl;
+    else
+      selection = wave;
+  }
+  const std::string fileName = options.positional[0];
+  const pitch::Table tuning = pitch::makeTuning(options.tuning, options.a4);
+  std::unique_ptr<EventSource> song;
+  try {
+    song = openSong(fileName, SAMPLE_RATE, tuning, !options.prerender);
+  } catch (const SongParseError &e) {
+    std::cerr << fileName << ":" << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+  // With --prerender the whole song is synthesised on every core before
+  // playback starts, and the audio callback only copies samples. The events
+  // are kept to drive the display and the timing statistics.
+  render::PcmBuffer<float> floatPcm;
+  render::PcmBuffer<int16_t> intPcm;
+  std::vector<SoundPlayer::NoteSpan> prerenderedNotes;
+  if (options.prerender) {
+    std::vector<SongEvent> events;
+    SongEvent event;
+    while (song->next(event))
+      events.push_back(event);
+    VectorEventSource source(events);
+    const render::Timeline timeline = render::timelineOf(source, SAMPLE_RATE);
+    for (const render::Note &note : timeline.notes)
+      prerenderedNotes.push_back({note.start, note.end});
+    const Mixer mixer = Mixer::forSelection(selection, options.dds);
+    const auto start = std::chrono::steady_clock::now();
+    if (options.dds)
+      intPcm = render::prerender<int16_t>(timeline, mixer, options.threads);
     else
-      selection = *argv[2];
+      floatPcm = render::prerender<float>(timeline, mixer, options.threads);
+    std::cerr << "Pre-rendered " << timeline.frames / SAMPLE_RATE << " s in "
+              << std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - start)
+                     .count()
+              << " s" << std::endl;
+    song = std::make_unique<VectorEventSource>(std::move(events));
   }
-  const std::string fileName = argv[1];
   std::signal(SIGINT, handle_signal);
   auto portaudioSession = std::make_shared<PortAudioSession>();
   g_portaudioWeak = portaudioSession;
+  // The sink comes before curses: a "-" sink moves the screen off stdout.
+  SoundPlayer player(selection, options.dds, options.sink);
   NcursesSession ncursesSession;
-  SoundPlayer player(selection);
-  NotePlayerAlsa notePlayer;
   NcursesDrawer drawer;
   drawer.init();
-  std::ifstream input(fileName);
-  if (!input.is_open()) {
-    std::cerr << "Failed to open file: " << fileName << "\n";
-    return EXIT_FAILURE;
+  NcursesUiThread ui(drawer, 60, options.fps);
+  ui.setStatus([&player] { return player.callbackTelemetry().statusLine(); });
+  ui.start();
+  Scheduler scheduler(options.spinUs);
+  OnsetTelemetry telemetry(options.stats);
+  uint64_t eventStartUs = 0;
+  uint64_t songEndUs = 0;
+  SongEvent event;
+  // With --stats each note is timed where the output actually placed it:
+  // from the frame the audio callback started it at, through the sink's
+  // latency. The scheduler only decides when notes are queued.
+  const auto collectOnsets = [&] {
+    SoundPlayer::Onset onset;
+    while (player.popOnset(onset))
+      telemetry.heard(onset.scheduledNs, onset.heardNs, onset.endHeardNs);
+  };
+  scheduler.start();
+  player.beginSong();
+  if (options.prerender) {
+    if (options.dds)
+      player.playBuffer(intPcm.samples.get(), intPcm.frames,
+                        std::move(prerenderedNotes));
+    else
+      player.playBuffer(floatPcm.samples.get(), floatPcm.frames,
+                        std::move(prerenderedNotes));
   }
-  int middleMIDINote = 60;
-  drawer.drawStaff(middleMIDINote);
-  int bpm = 100;
-  int octave = 0;
-  int noteCounter = 0;
-  std::string note;
-  std::string value;
-  while (true) {
-    if (!(input >> note)) {
-      break;
-    }
-
-    if (note == "bpm") {
-      if (!(input >> bpm)) {
-        std::cerr << "Error: 'bpm' command requires a numeric value.\n";
-        break;
-      }
-    } else if (note == "P") {
-      if (!(input >> value)) {
-        std::cerr << "Error: 'P' command requires a duration.\n";
-        break;
-      }
-      int durationMs = notePlayer.getDuration(value, bpm);
-      std::this_thread::sleep_for(std::chrono::milliseconds(durationMs));
-    } else {
-      if (!(input >> octave >> value)) {
-        std::cerr << "Malformed note line. Expected: <note> <octave> <value>\n";
-        break;
-      }
-      notePlayer.play(note, octave, value, player, bpm);
-      int noteOffset = getNoteOffset(note);
-      int midiNoteNumber = (octave + 1) * 12 + noteOffset;
-      int middleY = LINES / 2;
-      int verticalPosition = middleY - (midiNoteNumber - middleMIDINote);
-      if (verticalPosition < 2 || verticalPosition > (LINES - 2)) {
-        middleMIDINote = midiNoteNumber;
-        drawer.drawStaff(middleMIDINote);
-      }
-      int fractionary = notePlayer.getFractionary(value);
-      int fractionaryStemCount =
-          std::max(0, static_cast<int>(std::log2(fractionary) - 2));
-      drawer.drawNote(note, octave, value, fractionary, fractionaryStemCount,
-                      middleMIDINote, midiNoteNumber, ++noteCounter);
-    }
-    int ch = getch();
-    if (ch == 'q' || ch == 'Q')
-      break;
+  telemetry.start(player.songFrameNs(0));
+  while (!ui.quitRequested() && song->next(event)) {
+    eventStartUs += event.delayUs;
+    scheduler.waitUntil(eventStartUs);
+    const uint64_t eventEndUs = eventStartUs + event.durationUs;
+    const uint64_t frame = SoundPlayer::framesFromUs(eventStartUs);
+    const uint64_t endFrame = SoundPlayer::framesFromUs(eventEndUs);
+    songEndUs = std::max(songEndUs, eventEndUs);
+    // Rests need nothing: a voice falls silent at its own end frame.
+    if (event.kind == SongEvent::Kind::Note && !options.prerender)
+      player.scheduleNote(frame, endFrame, event.frequency);
+    telemetry.schedule(event, player.songFrameNs(frame),
+                       player.songFrameNs(endFrame));
+    collectOnsets();
+    ui.post(event);
   }
+  const uint64_t songEndFrame = SoundPlayer::framesFromUs(songEndUs);
+  if (ui.quitRequested())
+    player.stopTone();
+  else
+    player.finishSong(songEndFrame);
+  collectOnsets();
+  telemetry.finish(player.songFrameNs(songEndFrame),
+                   player.heardNs(songEndFrame));
+  ui.stop();
   drawer.displayIdle();
   drawer.waitForExit();
   drawer.end();
+  scheduler.printReport(std::cerr);
+  telemetry.printSummary(std::cerr);
+  player.callbackTelemetry().printSummary(std::cerr);
+  if (!options.statsCsv.empty())
+    telemetry.writeCsv(options.statsCsv);
 
   return EXIT_SUCCESS;
 } catch (const std::exception &e) {
@@ -0,0 +1,159 @@
+#include "include/Library/libraryindex.h"
+#include "include/Options/parsenumber.h"
+#include "include/Pitch/pitch.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace {
+constexpr const char *NOTE_NAMES[12] = {"C",  "C#", "D",  "D#", "E",  "F",
+                                        "F#", "G",  "G#", "A",  "A#", "B"};
+
+void printUsage(const char *progName) {
+  std::cerr << "Usage: " << progName
+            << " <index file> [--scan=<dir>] [--threads=<n>]"
+               " [--length=<min s>:<max s>] [--bpm=<min>:<max>]"
+               " [--pitch=<lowest>:<highest>] [--notes=<min>:<max>]\n"
+               "Either side of a range may be left out; pitches are note"
+               " names such as C#4, or MIDI numbers.\n";
+}
+
+double parseNumber(std::string_view name, const std::string &text) {
+  char *end = nullptr;
+  const double result = std::strtod(text.c_str(), &end);
+  if (text.empty() || *end != '\0' || result < 0.0)
+    throw std::invalid_argument("Invalid value for --" + std::string(name) +
+                                ": " + text);
+  return result;
+}
+
+// "C#4", "Bb-1" or a MIDI number.
+double parsePitch(std::string_view name, const std::string &text) {
+  std::size_t split = 0;
+  while (split < text.size() && (text[split] < '0' || text[split] > '9') &&
+         text[split] != '-')
+    ++split;
+  if (split == 0)
+    return parseNumber(name, text);
+  const int offset = pitch::noteOffset(std::string_view(text).substr(0, split));
+  const std::string octave = text.substr(split);
+  char *end = nullptr;
+  const long octaveNumber = std::strtol(octave.c_str(), &end, 10);
+  const int midi =
+      pitch::midiNumber(offset, static_cast<int>(octaveNumber));
+  if (offset < 0 || octave.empty() || *end != '\0' || midi < 0 || midi > 127)
+    throw std::invalid_argument("Invalid value for --" + std::string(name) +
+                                ": " + text);
+  return midi;
+}
+
+// Splits "<min>:<max>" and stores each side that is present.
+template <typename T, typename Parse>
+void parseRange(std::string_view name, const std::string &value, T &min,
+                T &max, double scale, Parse parse) {
+  const std::size_t colon = value.find(':');
+  if (colon == std::string::npos)
+    throw std::invalid_argument("Expected <min>:<max> for --" +
+                                std::string(name));
+  const std::string low = value.substr(0, colon);
+  const std::string high = value.substr(colon + 1);
+  if (!low.empty())
+    min = checkedCast<T>(name, parse(name, low) * scale, low);
+  if (!high.empty())
+    max = checkedCast<T>(name, parse(name, high) * scale, high);
+}
+
+std::string pitchName(uint8_t midi) {
+  return NOTE_NAMES[midi % 12] + std::to_string(midi / 12 - 1);
+}
+} // namespace
+
+int main(int argc, char **argv) try {
+  std::string indexPath;
+  std::string scanRoot;
+  unsigned threads = 0;
+  SongQuery query;
+  bool filtered = false;
+  try {
+    for (int i = 1; i < argc; ++i) {
+      const std::string_view arg = argv[i];
+      if (!arg.starts_with("--")) {
+        if (!indexPath.empty())
+          throw std::invalid_argument("Unexpected argument: " +
+                                      std::string(arg));
+        indexPath = arg;
+        continue;
+      }
+      const std::size_t eq = arg.find('=');
+      const std::string_view name = arg.substr(2, eq - 2);
+      const std::string value =
+          eq == std::string_view::npos ? "" : std::string(arg.substr(eq + 1));
+      if (name == "scan" && !value.empty()) {
+        scanRoot = value;
+      } else if (name == "threads") {
+        threads = checkedCast<unsigned>(name, parseNumber(name, value), value);
+      } else if (name == "length") {
+        parseRange(name, value, query.minLengthMs, query.maxLengthMs, 1000.0,
+                   parseNumber);
+      } else if (name == "bpm") {
+        parseRange(name, value, query.minBpm, query.maxBpm, 1.0, parseNumber);
+      } else if (name == "pitch") {
+        parseRange(name, value, query.lowestMidi, query.highestMidi, 1.0,
+                   parsePitch);
+      } else if (name == "notes") {
+        parseRange(name, value, query.minNotes, query.maxNotes, 1.0,
+                   parseNumber);
+      } else {
+        throw std::invalid_argument("Unknown option: " + std::string(arg));
+      }
+      filtered = filtered || (name != "scan" && name != "threads");
+    }
+  } catch (const std::invalid_argument &e) {
+    std::cerr << e.what() << "\n";
+    printUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  if (indexPath.empty()) {
+    printUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  LibraryIndex index = LibraryIndex::load(indexPath);
+  if (!scanRoot.empty()) {
+    const LibraryIndex::ScanReport report = index.scan(scanRoot, threads);
+    index.save(indexPath);
+    std::cerr << report.files << " scores, " << report.analyzed
+              << " analysed (" << report.unreadable << " unreadable), "
+              << report.removed << " removed\n";
+    // A plain scan lists nothing; add a range to query as well.
+    if (!filtered)
+      return EXIT_SUCCESS;
+  }
+
+  for (const LibraryIndex::Entry *entry : index.query(query)) {
+    const SongStats &stats = entry->stats;
+    const uint32_t seconds = (stats.lengthMs + 500) / 1000;
+    std::cout << seconds / 60 << ":" << std::setw(2) << std::setfill('0')
+              << seconds % 60 << std::setfill(' ') << "  " << std::setw(3)
+              << stats.minBpm << "-" << std::setw(3) << std::left
+              << stats.maxBpm << std::right << " bpm  ";
+    if (stats.noteCount > 0)
+      std::cout << std::setw(4) << pitchName(stats.lowestMidi) << "-"
+                << std::setw(4) << std::left << pitchName(stats.highestMidi)
+                << std::right;
+    else
+      std::cout << std::setw(9) << "-";
+    std::cout << "  " << std::setw(6) << stats.noteCount << " notes  "
+              << entry->path << "\n";
+  }
+  return EXIT_SUCCESS;
+} catch (const std::exception &e) {
+  std::cerr << "Error: " << e.what() << '\n';
+  return EXIT_FAILURE;
+}
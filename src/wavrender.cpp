@@ -0,0 +1,103 @@
+#include "include/Options/options.h"
+#include "include/Pitch/pitch.h"
+#include "include/Render/prerender.h"
+#include "include/Render/songrenderer.h"
+#include "include/Render/wavwriter.h"
+#include "include/SoundPlayer/mixer.h"
+#include "include/Song/eventsource.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace {
+constexpr double SAMPLE_RATE = 48000.0; // same rate as speaker_soundcard
+}
+
+void printUsage(const char *progName) {
+  std::cerr << "Usage: " << progName
+            << " <file_name | -> <output.wav> [Q/W/S/T | q/w/s/t]"
+               " [--float] [--dds] [--prerender] [--threads=<n>]"
+               " [--tuning=equal|just|<cents file>] [--a4=<Hz>]\n";
+}
+
+int main(int argc, char **argv) try {
+  PlayerOptions options;
+  try {
+    options = parsePlayerOptions(argc, argv);
+  } catch (const std::invalid_argument &e) {
+    std::cerr << e.what() << "\n";
+    printUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  if (options.positional.size() < 2) {
+    printUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  char selection = 'Q'; // default is square wave, as in speaker_soundcard
+  if (options.positional.size() >= 3) {
+    const char wave = options.positional[2][0];
+    if (wave == '\0' || std::strchr("QWSTqwst", wave) == nullptr)
+      std::cout << "Invalid wave selection. Defaulting to square" << std::endl;
+    else
+      selection = wave;
+  }
+  const std::string inputFileName = options.positional[0];
+  const std::string outputFileName = options.positional[1];
+  const pitch::Table tuning = pitch::makeTuning(options.tuning, options.a4);
+  std::unique_ptr<EventSource> song;
+  try {
+    song = openSong(inputFileName, SAMPLE_RATE, tuning, false);
+  } catch (const SongParseError &e) {
+    std::cerr << inputFileName << ":" << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  Mixer mixer = Mixer::forSelection(selection, options.dds);
+  WavWriter wav(outputFileName, static_cast<uint32_t>(SAMPLE_RATE),
+                options.floatOutput ? WavWriter::Format::Float32
+                                    : WavWriter::Format::Int16);
+  const auto start = std::chrono::steady_clock::now();
+  auto sink = [&](const auto *samples, std::size_t frames) {
+    wav.write(samples, frames);
+  };
+  uint64_t frames = 0;
+  if (options.prerender) {
+    // Whole song in memory on every core, then one sequential write. The
+    // samples are identical to the streaming render below.
+    const render::Timeline timeline = render::timelineOf(*song, SAMPLE_RATE);
+    auto write = [&](const auto &pcm) {
+      sink(pcm.samples.get(), static_cast<std::size_t>(pcm.frames));
+      frames = pcm.frames;
+    };
+    if (options.dds)
+      write(render::prerender<int16_t>(timeline, mixer, options.threads));
+    else
+      write(render::prerender<float>(timeline, mixer, options.threads));
+  } else {
+    frames = options.dds
+                 ? render::renderSong<int16_t>(*song, mixer, SAMPLE_RATE, sink)
+                 : render::renderSong<float>(*song, mixer, SAMPLE_RATE, sink);
+  }
+  wav.close();
+  const double wallSeconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+
+  const double audioSeconds = frames / SAMPLE_RATE;
+  std::cout << "Rendered " << audioSeconds << " s of "
+            << Mixer::describeSelection(selection, options.dds) << " to "
+            << outputFileName << " ("
+            << (options.floatOutput ? "32-bit float" : "16-bit") << ") in "
+            << wallSeconds << " s, real-time factor "
+            << audioSeconds / wallSeconds << "x\n";
+  return EXIT_SUCCESS;
+} catch (const std::exception &e) {
+  std::cerr << "Error: " << e.what() << '\n';
+  return EXIT_FAILURE;
+}